@@ -0,0 +1,107 @@
+#pragma once
+#include <pthread.h>
+#include <sched.h>
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace cor3ntin::corio {
+
+// The cpus the calling thread is allowed to run on, in increasing order.
+// This honours taskset and cgroup restrictions, unlike std::thread::hardware_concurrency
+inline std::vector<unsigned> available_cpus() {
+    std::vector<unsigned> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if(sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for(unsigned cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if(CPU_ISSET(cpu, &set)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+    return cpus;
+}
+
+// Parses a list of cpus in the format of sysfs and cpusets, "0-3,8,10-11"
+inline std::vector<unsigned> parse_cpu_list(std::string_view list) {
+    std::vector<unsigned> cpus;
+    while(!list.empty()) {
+        const auto comma = list.find(',');
+        const auto item = list.substr(0, comma);
+        list = comma == list.npos ? std::string_view{} : list.substr(comma + 1);
+        unsigned first = 0, last = 0;
+        auto [end, ec] = std::from_chars(item.data(), item.data() + item.size(), first);
+        if(ec != std::errc{}) {
+            continue;
+        }
+        last = first;
+        if(end != item.data() + item.size() && *end == '-') {
+            std::from_chars(end + 1, item.data() + item.size(), last);
+        }
+        for(unsigned cpu = first; cpu <= last; cpu++) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+// A numa node and the cpus of it the calling thread is allowed to run on
+struct numa_node {
+    unsigned id;
+    std::vector<unsigned> cpus;
+};
+
+// The numa nodes which have available cpus, in increasing order of id, read from
+// /sys/devices/system/node. When that is not there, on kernels without numa support,
+// a single node 0 with all the available cpus
+inline std::vector<numa_node> numa_nodes() {
+    const auto available = available_cpus();
+    std::vector<numa_node> nodes;
+    std::error_code ec;
+    for(auto& entry : std::filesystem::directory_iterator("/sys/devices/system/node", ec)) {
+        const auto name = entry.path().filename().string();
+        unsigned id;
+        if(!name.starts_with("node") ||
+           std::from_chars(name.data() + 4, name.data() + name.size(), id).ec != std::errc{}) {
+            continue;
+        }
+        std::ifstream file(entry.path() / "cpulist");
+        std::string list;
+        if(!std::getline(file, list)) {
+            continue;
+        }
+        numa_node node{id, {}};
+        for(auto cpu : parse_cpu_list(list)) {
+            if(std::binary_search(available.begin(), available.end(), cpu)) {
+                node.cpus.push_back(cpu);
+            }
+        }
+        if(!node.cpus.empty()) {
+            nodes.push_back(std::move(node));
+        }
+    }
+    if(nodes.empty()) {
+        nodes.push_back({0, available});
+    }
+    std::sort(nodes.begin(), nodes.end(), [](auto& a, auto& b) { return a.id < b.id; });
+    return nodes;
+}
+
+// Restricts the calling thread to run on cpu
+inline std::error_code pin_current_thread(unsigned cpu) noexcept {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if(auto ret = pthread_setaffinity_np(pthread_self(), sizeof(set), &set)) {
+        return std::make_error_code(std::errc(ret));
+    }
+    return {};
+}
+
+}  // namespace cor3ntin::corio
@@ -0,0 +1,46 @@
+#pragma once
+#include <corio/tag_invoke.hpp>
+#include <corio/then.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+
+namespace cor3ntin::corio {
+
+// bulk(scheduler, n, f) is a sender which calls f(i) for every i in [0, n) on the
+// execution context of scheduler, possibly in parallel, and completes once all calls returned.
+// If a call throws, the sender completes with the first exception, after the other calls.
+// Schedulers opt in to running the calls in parallel by customizing bulk through tag_invoke,
+// other schedulers make them one after the other
+namespace __bulk_ns {
+    struct __bulk_base {};
+}  // namespace __bulk_ns
+inline constexpr struct __bulk_fn : __bulk_ns::__bulk_base {
+    template <typename Scheduler, typename F>
+    requires cor3ntin::corio::tag_invocable<__bulk_fn, const Scheduler&, std::size_t, F> auto
+    operator()(const Scheduler& s, std::size_t n, F&& f) const {
+        return cor3ntin::corio::tag_invoke(*this, s, n, (F &&) f);
+    }
+    template <typename Scheduler, typename F>
+    requires(!cor3ntin::corio::tag_invocable<__bulk_fn, const Scheduler&, std::size_t, F>) auto
+    operator()(const Scheduler& s, std::size_t n, F&& f) const {
+        return then(s.schedule(), [n, f = (F &&) f]() mutable {
+            for(std::size_t i = 0; i < n; ++i)
+                f(i);
+        });
+    }
+} bulk;
+
+// parallel_for(scheduler, n, f, grain) calls f(begin, end) on consecutive ranges of
+// at most grain indices covering [0, n), so that f can run a tight loop over each range
+template <typename Scheduler, typename F>
+auto parallel_for(const Scheduler& s, std::size_t n, F&& f, std::size_t grain = 1024) {
+    grain = std::max<std::size_t>(grain, 1);
+    return bulk(s, (n + grain - 1) / grain,
+                [n, grain, f = (F &&) f](std::size_t i) mutable {
+                    const auto begin = i * grain;
+                    f(begin, std::min(n, begin + grain));
+                });
+}
+
+}  // namespace cor3ntin::corio
@@ -120,7 +120,7 @@ namespace details {
 
                     if(empty) {
                         if(c->m_capacity == 0) {
-                            execution::set_error(m_receiver, channel_closed{});
+                            execution::set_error(std::move(m_receiver), channel_closed{});
                             return;
                         }
                         c->add_reader(this);
@@ -141,13 +141,13 @@ namespace details {
 
             protected:
                 void handle_value(T&& value) override {
-                    execution::set_value(m_receiver, std::move(value));
+                    execution::set_value(std::move(m_receiver), std::move(value));
                 }
                 void handle_error(std::error_code err) override {
                     if(err == std::errc::bad_file_descriptor)
-                        execution::set_error(m_receiver, channel_closed{});
+                        execution::set_error(std::move(m_receiver), channel_closed{});
                     else
-                        execution::set_error(m_receiver, err);
+                        execution::set_error(std::move(m_receiver), err);
                 }
 
             private:
@@ -219,7 +219,7 @@ namespace details {
                 void start() {
                     auto* c = m_sender.m_channel;
                     if(c->m_capacity == 0) {
-                        execution::set_error(m_receiver, channel_closed{});
+                        execution::set_error(std::move(m_receiver), channel_closed{});
                         return;
                     }
                     auto reader = c->m_pending_readers.pop();
@@ -244,12 +244,12 @@ namespace details {
             protected:
                 void handle_error(std::error_code err) override {
                     if(err == std::errc::bad_file_descriptor)
-                        execution::set_error(m_receiver, channel_closed{});
+                        execution::set_error(std::move(m_receiver), channel_closed{});
                     else
-                        execution::set_error(m_receiver, err);
+                        execution::set_error(std::move(m_receiver), err);
                 }
                 void handle_value() override {
-                    execution::set_value(m_receiver);
+                    execution::set_value(std::move(m_receiver));
                 }
                 T& value() override {
                     return m_sender.m_value;
@@ -8,6 +8,7 @@
 #include <corio/tag_invoke.hpp>
 #include <corio/spawn.hpp>
 #include <corio/meta.hpp>
+#include <corio/stop_token.hpp>
 
 namespace cor3ntin::corio {
 
@@ -36,11 +37,11 @@ namespace execution {
             cor3ntin::corio::tag_invoke(*this, (Receiver &&) r);
         }
         template <typename Receiver>
-        requires requires(Receiver& r) {
-            r.set_done();
+        requires requires(Receiver&& r) {
+            ((Receiver &&) r).set_done();
         }
         friend void tag_invoke(__set_done_fn, Receiver&& r) noexcept {
-            r.set_done();
+            ((Receiver &&) r).set_done();
         }
     } set_done;
 
@@ -55,11 +56,11 @@ namespace execution {
             cor3ntin::corio::tag_invoke(*this, (Receiver &&) r, (Value &&) v...);
         }
         template <typename Receiver, typename... Value>
-        requires requires(Receiver& r, Value&&... v) {
-            {r.set_value((Value &&) v...)};
+        requires requires(Receiver&& r, Value&&... v) {
+            {((Receiver &&) r).set_value((Value &&) v...)};
         }
         friend void tag_invoke(__set_value_fn, Receiver&& r, Value&&... v) noexcept {
-            r.set_value((Value &&) v...);
+            ((Receiver &&) r).set_value((Value &&) v...);
         }
     } set_value;
 
@@ -75,14 +76,40 @@ namespace execution {
         }
         template <typename Receiver, typename Error>
         requires requires(Receiver&& r, Error&& e) {
-            r.set_error(e);
+            ((Receiver &&) r).set_error((Error &&) e);
         }
         friend void tag_invoke(__set_error_fn, Receiver&& r, Error&& e) noexcept {
-            r.set_error(e);
+            ((Receiver &&) r).set_error((Error &&) e);
         }
     } set_error;
 
 
+    namespace __get_stop_token_ns {
+        struct __get_stop_token_base {};
+    }  // namespace __get_stop_token_ns
+    inline constexpr struct __get_stop_token_fn : __get_stop_token_ns::__get_stop_token_base {
+        template <typename Receiver>
+        requires cor3ntin::corio::tag_invocable<__get_stop_token_fn, const Receiver&> auto
+        operator()(const Receiver& r) const noexcept {
+            return cor3ntin::corio::tag_invoke(*this, r);
+        }
+        // receivers which do not provide a token are never asked to stop
+        template <typename Receiver>
+        requires(!cor3ntin::corio::tag_invocable<__get_stop_token_fn, const Receiver&>)
+            stop_token
+            operator()(const Receiver&) const noexcept {
+            return {};
+        }
+        template <typename Receiver>
+        requires requires(const Receiver& r) {
+            r.get_stop_token();
+        }
+        friend auto tag_invoke(__get_stop_token_fn, const Receiver& r) noexcept {
+            return r.get_stop_token();
+        }
+    } get_stop_token;
+
+
     namespace __connect_ns {
         struct __connect_base {};
     }  // namespace __connect_ns
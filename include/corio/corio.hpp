@@ -6,5 +6,9 @@
 #include <corio/as_receiver.hpp>
 #include <corio/stop_token.hpp>
 #include <corio/io_uring.hpp>
+#include <corio/io_uring_pool.hpp>
 #include <corio/channel.hpp>
-#include <corio/then.hpp>
\ No newline at end of file
+#include <corio/then.hpp>
+#include <corio/timeout.hpp>
+#include <corio/bulk.hpp>
+#include <corio/numeric.hpp>
\ No newline at end of file
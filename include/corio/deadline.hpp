@@ -1,17 +1,48 @@
 #pragma once
 #include <chrono>
+#include <type_traits>
+#include <time.h>
 
 struct __kernel_timespec;
 
 namespace cor3ntin::corio {
 
+// Like steady_clock, but keeps counting while the system is suspended
+struct boot_clock {
+    using duration = std::chrono::nanoseconds;
+    using rep = duration::rep;
+    using period = duration::period;
+    using time_point = std::chrono::time_point<boot_clock>;
+    static constexpr bool is_steady = true;
+
+    static time_point now() noexcept {
+        timespec ts;
+        clock_gettime(CLOCK_BOOTTIME, &ts);
+        return time_point(std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec));
+    }
+};
+
 struct deadline {
+    // the clock an absolute deadline is measured against
+    enum class clock { monotonic, realtime, boottime };
+
     constexpr deadline() noexcept = default;
     constexpr explicit operator bool() const noexcept {
-        return d.count() != 0;
+        return absolute || d.count() != 0;
     }
+    // steady_clock, system_clock and boot_clock time points are absolute deadlines,
+    // time points of other clocks are converted to a duration from now
     template <class Clock, class Duration>
     constexpr deadline(std::chrono::time_point<Clock, Duration> tp) noexcept {
+        if constexpr(std::is_same_v<Clock, std::chrono::system_clock>) {
+            this->c = clock::realtime;
+        } else if constexpr(std::is_same_v<Clock, boot_clock>) {
+            this->c = clock::boottime;
+        } else if constexpr(!std::is_same_v<Clock, std::chrono::steady_clock>) {
+            this->d = std::chrono::duration_cast<std::chrono::nanoseconds>(tp - Clock::now());
+            this->absolute = false;
+            return;
+        }
         this->d = std::chrono::duration_cast<std::chrono::nanoseconds>(tp.time_since_epoch());
         this->absolute = true;
     }
@@ -23,8 +54,10 @@ struct deadline {
 
 private:
     friend __kernel_timespec to_timespec(const deadline& d);
-    std::chrono::nanoseconds d;
+    friend unsigned timeout_flags(const deadline& d);
+    std::chrono::nanoseconds d{};
     bool absolute = false;
+    clock c = clock::monotonic;
 };
 
 }  // namespace cor3ntin::corio
@@ -1,8 +1,36 @@
 #pragma once
+#include <array>
+#include <vector>
 #include <corio/io_uring/base.hpp>
 #include <corio/io_uring/schedule.hpp>
 #include <corio/io_uring/cancel.hpp>
 #include <corio/io_uring/read.hpp>
+#include <corio/io_uring/write.hpp>
+#include <corio/io_uring/readv.hpp>
+#include <corio/io_uring/writev.hpp>
+#include <corio/io_uring/read_fixed.hpp>
+#include <corio/io_uring/write_fixed.hpp>
+#include <corio/io_uring/accept.hpp>
+#include <corio/io_uring/connect.hpp>
+#include <corio/io_uring/recv.hpp>
+#include <corio/io_uring/send.hpp>
+#include <corio/io_uring/send_zc.hpp>
+#include <corio/io_uring/recvmsg.hpp>
+#include <corio/io_uring/sendmsg.hpp>
+#include <corio/io_uring/close.hpp>
+#include <corio/io_uring/splice.hpp>
+#include <corio/io_uring/tee.hpp>
+#include <corio/io_uring/sendfile.hpp>
+#include <corio/io_uring/openat.hpp>
+#include <corio/io_uring/statx.hpp>
+#include <corio/io_uring/fsync.hpp>
+#include <corio/io_uring/sync_file_range.hpp>
+#include <corio/io_uring/fallocate.hpp>
+#include <corio/io_uring/renameat.hpp>
+#include <corio/io_uring/unlinkat.hpp>
+#include <corio/io_uring/buffer_ring.hpp>
+#include <corio/io_uring/accept_multishot.hpp>
+#include <corio/io_uring/recv_multishot.hpp>
 
 namespace cor3ntin::corio {
 class io_uring_context;
@@ -12,16 +40,192 @@ namespace iouring {
     public:
         // scheduler(io_uring_context* ctx) : m_ctx(ctx) {}
 
-        schedule::sender schedule() {
+        schedule::sender schedule() const {
             return schedule::sender{m_ctx};
         }
-        schedule::sender schedule(deadline d) {
+        schedule::sender schedule(deadline d) const {
             return schedule::sender{m_ctx, d};
         }
 
-        friend auto async_read(iouring::scheduler sch, iouring::native_file_handle fd, void* buffer,
+        friend auto async_read(iouring::scheduler sch, iouring::file_handle fd, void* buffer,
                                std::size_t size) {
-            return read::sender(sch.m_ctx, fd, buffer, size);
+            return read::sender(sch.m_ctx, fd, buffer, size, current_position);
+        }
+
+        // Reads at the given offset without using or updating the file position,
+        // so that several reads of the same file can be in flight at once
+        friend auto async_read_at(iouring::scheduler sch, iouring::file_handle fd,
+                                  std::uint64_t offset, void* buffer, std::size_t size) {
+            return read::sender(sch.m_ctx, fd, buffer, size, offset);
+        }
+
+        friend auto async_write(iouring::scheduler sch, iouring::file_handle fd, const void* buffer,
+                                std::size_t size) {
+            return write::sender(sch.m_ctx, fd, buffer, size, current_position);
+        }
+
+        friend auto async_write_at(iouring::scheduler sch, iouring::file_handle fd,
+                                   std::uint64_t offset, const void* buffer, std::size_t size) {
+            return write::sender(sch.m_ctx, fd, buffer, size, offset);
+        }
+
+        // The iovec array must stay alive until the operation completes
+        friend auto async_readv(iouring::scheduler sch, iouring::file_handle fd,
+                                std::span<const iovec> buffers,
+                                std::uint64_t offset = current_position) {
+            return readv::sender(sch.m_ctx, fd, buffers, offset);
+        }
+
+        friend auto async_writev(iouring::scheduler sch, iouring::file_handle fd,
+                                 std::span<const iovec> buffers,
+                                 std::uint64_t offset = current_position) {
+            return writev::sender(sch.m_ctx, fd, buffers, offset);
+        }
+
+        // buffer must lie within the buffer registered at buffer_index
+        friend auto async_read_fixed(iouring::scheduler sch, iouring::file_handle fd,
+                                     void* buffer, std::size_t size, int buffer_index,
+                                     std::uint64_t offset = current_position) {
+            return read_fixed::sender(sch.m_ctx, fd, buffer, size, buffer_index, offset);
+        }
+
+        friend auto async_write_fixed(iouring::scheduler sch, iouring::file_handle fd,
+                                      const void* buffer, std::size_t size, int buffer_index,
+                                      std::uint64_t offset = current_position) {
+            return write_fixed::sender(sch.m_ctx, fd, buffer, size, buffer_index, offset);
+        }
+
+        // Sends the descriptor of the accepted connection.
+        // address and address_size are filled with the address of the peer if not null.
+        friend auto async_accept(iouring::scheduler sch, iouring::file_handle fd,
+                                 sockaddr* address = nullptr, socklen_t* address_size = nullptr,
+                                 int flags = 0) {
+            return accept::sender(sch.m_ctx, fd, address, address_size, flags);
+        }
+
+        friend auto async_connect(iouring::scheduler sch, iouring::file_handle fd,
+                                  const sockaddr* address, socklen_t address_size) {
+            return connect::sender(sch.m_ctx, fd, address, address_size);
+        }
+
+        friend auto async_recv(iouring::scheduler sch, iouring::file_handle fd, void* buffer,
+                               std::size_t size, int flags = 0) {
+            return recv::sender(sch.m_ctx, fd, buffer, size, flags);
+        }
+
+        friend auto async_send(iouring::scheduler sch, iouring::file_handle fd, const void* buffer,
+                               std::size_t size, int flags = 0) {
+            return send::sender(sch.m_ctx, fd, buffer, size, flags);
+        }
+
+        // As async_send, without copying large buffers, see send_zc::sender
+        friend auto async_send_zc(iouring::scheduler sch, iouring::file_handle fd,
+                                  const void* buffer, std::size_t size, int flags = 0) {
+            return send_zc::sender(sch.m_ctx, fd, buffer, size, flags);
+        }
+
+        // Moves up to size bytes between two files, one of which must be a pipe.
+        // Offsets must be current_position for pipes.
+        friend auto async_splice(iouring::scheduler sch, iouring::file_handle in,
+                                 std::uint64_t in_offset, iouring::file_handle out,
+                                 std::uint64_t out_offset, unsigned size, unsigned flags = 0) {
+            return splice::sender(sch.m_ctx, in, in_offset, out, out_offset, size, flags);
+        }
+
+        // Duplicates up to size bytes from the pipe in to the pipe out, without consuming them
+        friend auto async_tee(iouring::scheduler sch, iouring::file_handle in,
+                              iouring::file_handle out, unsigned size, unsigned flags = 0) {
+            return tee::sender(sch.m_ctx, in, out, size, flags);
+        }
+
+        friend auto async_sendfile(iouring::scheduler sch, iouring::file_handle file,
+                                   iouring::file_handle socket, std::uint64_t offset,
+                                   std::size_t size) {
+            return sendfile::sender(sch.m_ctx, file, socket, offset, size);
+        }
+
+        // Sends the opened file descriptor
+        friend auto async_openat(iouring::scheduler sch, int dir, std::string path, int flags,
+                                 mode_t mode = 0) {
+            return openat::sender(sch.m_ctx, dir, std::move(path), flags, mode);
+        }
+
+        friend auto async_open(iouring::scheduler sch, std::string path, int flags,
+                               mode_t mode = 0) {
+            return openat::sender(sch.m_ctx, AT_FDCWD, std::move(path), flags, mode);
+        }
+
+        friend auto async_statx(iouring::scheduler sch, int dir, std::string path, int flags,
+                                unsigned mask, struct statx* result) {
+            return statx::sender(sch.m_ctx, dir, std::move(path), flags, mask, result);
+        }
+
+        // Makes [offset, offset + size) of the file durable, size 0 extends to the end of the
+        // file. A write-ahead log syncs the range it just appended
+        friend auto async_fsync(iouring::scheduler sch, iouring::file_handle fd,
+                                std::uint64_t offset = 0, unsigned size = 0) {
+            return fsync::sender(sch.m_ctx, fd, 0, offset, size);
+        }
+
+        // Only flushes the metadata needed to read the data back, as fdatasync(2)
+        friend auto async_fdatasync(iouring::scheduler sch, iouring::file_handle fd,
+                                    std::uint64_t offset = 0, unsigned size = 0) {
+            return fsync::sender(sch.m_ctx, fd, IORING_FSYNC_DATASYNC, offset, size);
+        }
+
+        // Starts writeback of a range of the file, see sync_file_range(2) for flags.
+        // This does not flush the metadata, and does not make the range durable on its own,
+        // use async_fsync or async_fdatasync with a range for that.
+        friend auto async_sync_file_range(iouring::scheduler sch, iouring::file_handle fd,
+                                          std::uint64_t offset, unsigned size,
+                                          int flags = SYNC_FILE_RANGE_WRITE) {
+            return sync_file_range::sender(sch.m_ctx, fd, offset, size, flags);
+        }
+
+        friend auto async_fallocate(iouring::scheduler sch, iouring::file_handle fd, int mode,
+                                    std::uint64_t offset, std::uint64_t size) {
+            return fallocate::sender(sch.m_ctx, fd, mode, offset, size);
+        }
+
+        friend auto async_renameat(iouring::scheduler sch, int old_dir, std::string old_path,
+                                   int new_dir, std::string new_path, unsigned flags = 0) {
+            return renameat::sender(sch.m_ctx, old_dir, std::move(old_path), new_dir,
+                                    std::move(new_path), flags);
+        }
+
+        friend auto async_unlinkat(iouring::scheduler sch, int dir, std::string path,
+                                   int flags = 0) {
+            return unlinkat::sender(sch.m_ctx, dir, std::move(path), flags);
+        }
+
+        friend auto async_recvmsg(iouring::scheduler sch, iouring::file_handle fd,
+                                  msghdr* message, unsigned flags = 0) {
+            return recvmsg::sender(sch.m_ctx, fd, message, flags);
+        }
+
+        friend auto async_sendmsg(iouring::scheduler sch, iouring::file_handle fd,
+                                  const msghdr* message, unsigned flags = 0) {
+            return sendmsg::sender(sch.m_ctx, fd, message, flags);
+        }
+
+        // Calls f(native_file_handle) for each accepted connection, until cancelled
+        template <typename F>
+        friend auto async_accept_multishot(iouring::scheduler sch, iouring::file_handle fd, F f,
+                                           int flags = 0) {
+            return accept_multishot::sender<F>(sch.m_ctx, fd, std::move(f), flags);
+        }
+
+        // Calls f(const void* data, std::size_t size) for each chunk of data received,
+        // until the connection is shut down or the operation is cancelled
+        template <typename F>
+        friend auto async_recv_multishot(iouring::scheduler sch, iouring::file_handle fd,
+                                         iouring::buffer_ring& buffers, F f, int flags = 0) {
+            return recv_multishot::sender<F>(sch.m_ctx, fd, buffers, std::move(f), flags);
+        }
+
+        // Closing a registered file also removes it from the registered file table
+        friend auto async_close(iouring::scheduler sch, iouring::file_handle fd) {
+            return close::sender(sch.m_ctx, fd);
         }
 
     private:
@@ -36,121 +240,833 @@ namespace iouring {
 }  // namespace iouring
 
 
+struct io_uring_options {
+    // number of submission queue entries, rounded up to a power of 2 by the kernel
+    unsigned sq_entries = 128;
+    // number of completion queue entries, 0 lets the kernel use twice sq_entries
+    unsigned cq_entries = 0;
+
+    // a kernel thread polls the submission queue, so submissions do not need a syscall
+    bool sqpoll = false;
+    // time after which the idle polling thread goes to sleep, 0 for the kernel default
+    std::chrono::milliseconds sqpoll_idle{0};
+    // cpu the polling thread is pinned to, -1 to let the scheduler decide
+    int sqpoll_cpu = -1;
+
+    // only the thread calling run() submits to the ring
+    bool single_issuer = false;
+    // do not interrupt the running thread to process completions
+    bool coop_taskrun = false;
+    // only process completions when run() waits for them. implies single_issuer
+    bool defer_taskrun = false;
+
+    // Granularity of the timer wheel which multiplexes schedule(deadline) operations onto a
+    // single kernel timeout. Timers fire up to that much late, never early.
+    // 0 submits a kernel timeout for each operation instead.
+    std::chrono::nanoseconds timer_resolution = std::chrono::milliseconds(1);
+
+    // maximum number of operations submitted to the kernel and not yet completed,
+    // further operations wait in the context's queue. 0 uses the size of the completion queue
+    unsigned max_in_flight = 0;
+
+    // Before blocking for completions, the loop polls the completion queue and its own
+    // queues for up to that long, trading cpu time for wakeup latency. 0 always blocks
+    std::chrono::nanoseconds spin{0};
+};
+
+struct io_uring_statistics {
+    static constexpr std::size_t histogram_size = 8;
+
+    // number of times the loop woke up with completions to process
+    std::uint64_t wakeups;
+    std::uint64_t completions;
+    // largest number of completions processed in a single wakeup
+    std::uint64_t max_batch;
+    // batch_histogram[i] counts wakeups which processed [2^i, 2^(i+1)) completions,
+    // the last bucket counts everything above
+    std::array<std::uint64_t, histogram_size> batch_histogram;
+
+    // timers waiting in the timer wheel
+    std::uint64_t timers;
+    // operations waiting in the context's queue to be submitted
+    std::uint64_t queued;
+    // operations submitted to the kernel and not yet completed
+    std::uint64_t in_flight;
+    // number of times the submission queue was full and had to be flushed
+    std::uint64_t sq_full;
+    // number of times the kernel held back completions because the completion queue was full
+    std::uint64_t cq_backlogged;
+    // completions dropped by the kernel
+    std::uint64_t cq_overflows;
+    // number of times submitting to the kernel failed, the operations stay queued in the ring
+    std::uint64_t submit_errors;
+
+    // time spent polling for completions, see io_uring_options::spin
+    std::chrono::nanoseconds spinning;
+    // time spent blocked waiting for completions
+    std::chrono::nanoseconds sleeping;
+};
+
 class io_uring_context {
     friend iouring::operation_base;
 
 public:
-    io_uring_context() {
-        // init();
+    explicit io_uring_context(io_uring_options options = {}) {
+        init(options);
+    }
+    ~io_uring_context() {
+        m_buffer_rings.clear();
+        io_uring_queue_exit(&m_ring);
+        ::close(m_notify_fd);
     }
-    ~io_uring_context() {}
 
     void run(corio::stop_token stop_token) {
         stop_callback _(stop_token, [this] {
             m_stopped = true;
-            notify();
+            signal();
         });
-        init();
-        schedule_queue_read();
+        running r(this);
         while(!m_stopped) {
-            schedule_pendings();
-            if(io_uring_submit(&m_ring) < 0) {
-                std::cout << "Submit failed\n";
-            }
-            struct io_uring_cqe* cqe;
-            auto ret = io_uring_wait_cqe(&m_ring, &cqe);
-            if(!cqe) {
-                std::cout << "No cqe";
-                continue;
-            }
-            if(cqe->user_data == 0) {
-                // ignore, maybe a cancel operation ?
-            } else if(cqe->user_data == uint64_t(this)) {
-                uint64_t c;
-                eventfd_read(m_notify_fd, &c);
-                m_notify = true;
-            } else {
-                // std::cout << "Operation " << cqe->res << " " << cqe->user_data << "\n";
-                auto op = reinterpret_cast<iouring::operation_base*>(cqe->user_data);
-                if(op) {
-                    op->set_result(cqe);
-                }
-            }
-            io_uring_cqe_seen(&m_ring, cqe);
+            run_once(true);
         }
-        io_uring_queue_exit(&m_ring);
+    }
+
+    // poll, run_one and run_for drive the context from a loop the caller owns, they must
+    // always be called from the same thread, and not concurrently with run().
+    // A loop waiting on an eventfd registered with register_eventfd is woken up
+    // when there is something to do, and should then call poll().
+
+    // Processes the operations that are ready, without blocking.
+    // Returns the number of operations completed
+    std::size_t poll() {
+        running r(this);
+        return run_once(false);
+    }
+
+    // Blocks until at least one operation completes, returns the number of operations completed
+    std::size_t run_one() {
+        running r(this);
+        std::size_t n = 0;
+        while(n == 0 && !m_stopped) {
+            n = run_once(true);
+        }
+        return n;
+    }
+
+    // Processes operations for the given duration, returns the number of operations completed
+    template <typename Rep, typename Period>
+    std::size_t run_for(std::chrono::duration<Rep, Period> d) {
+        running r(this);
+        const auto end = std::chrono::steady_clock::now() + d;
+        std::size_t n = 0;
+        for(auto now = std::chrono::steady_clock::now(); now < end && !m_stopped;
+            now = std::chrono::steady_clock::now()) {
+            auto ts = to_kernel_timespec(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(end - now));
+            n += run_once(true, &ts);
+        }
+        return n;
+    }
+
+    // The kernel signals fd whenever a completion is posted to the ring
+    std::error_code register_eventfd(int fd) noexcept {
+        return register_result(io_uring_register_eventfd(&m_ring, fd));
+    }
+
+    std::error_code unregister_eventfd() noexcept {
+        return register_result(io_uring_unregister_eventfd(&m_ring));
     }
     auto scheduler() noexcept {
         return iouring::scheduler{this};
     }
 
-private:
-    static constexpr int URING_ENTRIES = 128;
+    // Can be called from any thread
+    io_uring_statistics statistics() const noexcept {
+        io_uring_statistics s;
+        s.wakeups = m_counters.wakeups.load(std::memory_order_relaxed);
+        s.completions = m_counters.completions.load(std::memory_order_relaxed);
+        s.max_batch = m_counters.max_batch.load(std::memory_order_relaxed);
+        for(std::size_t i = 0; i < s.batch_histogram.size(); i++) {
+            s.batch_histogram[i] = m_counters.batch_histogram[i].load(std::memory_order_relaxed);
+        }
+        s.timers = m_counters.timers.load(std::memory_order_relaxed);
+        s.queued = m_queued.load(std::memory_order_relaxed);
+        s.in_flight = m_counters.in_flight.load(std::memory_order_relaxed);
+        s.sq_full = m_counters.sq_full.load(std::memory_order_relaxed);
+        s.cq_backlogged = m_counters.cq_backlogged.load(std::memory_order_relaxed);
+        s.cq_overflows = __atomic_load_n(m_ring.cq.koverflow, __ATOMIC_RELAXED);
+        s.submit_errors = m_counters.submit_errors.load(std::memory_order_relaxed);
+        s.spinning = std::chrono::nanoseconds(m_counters.spinning.load(std::memory_order_relaxed));
+        s.sleeping = std::chrono::nanoseconds(m_counters.sleeping.load(std::memory_order_relaxed));
+        return s;
+    }
 
+    // Operations queued or in flight, can be called from any thread
+    std::uint64_t load() const noexcept {
+        return m_queued.load(std::memory_order_relaxed) +
+            m_counters.in_flight.load(std::memory_order_relaxed);
+    }
+
+    // Registers buffers with the kernel so that async_read_fixed / async_write_fixed
+    // can refer to them by index, without the pages being pinned for each request.
+    // This should be called before run() or from the thread running the context.
+    std::error_code register_buffers(const iovec* buffers, unsigned count) noexcept {
+        return register_result(io_uring_register_buffers(&m_ring, buffers, count));
+    }
+
+    std::error_code unregister_buffers() noexcept {
+        return register_result(io_uring_unregister_buffers(&m_ring));
+    }
+
+    // Registers a table of files, operations can then refer to an entry of the table
+    // with iouring::registered_file{index}.
+    // -1 entries are left empty and can be filled later with update_registered_file.
+    // As for buffers, this should be called before run() or from the thread running the context.
+    std::error_code register_files(const iouring::native_file_handle* fds,
+                                   unsigned count) noexcept {
+        return register_result(io_uring_register_files(&m_ring, fds, count));
+    }
+
+    // Registers a table of count empty slots
+    std::error_code register_files_sparse(unsigned count) noexcept {
+        return register_result(io_uring_register_files_sparse(&m_ring, count));
+    }
+
+    // Replaces the file in the given slot, -1 empties the slot
+    std::error_code update_registered_file(iouring::registered_file file,
+                                           iouring::native_file_handle fd) noexcept {
+        return register_result(io_uring_register_files_update(&m_ring, file.index, &fd, 1));
+    }
+
+    std::error_code unregister_files() noexcept {
+        return register_result(io_uring_unregister_files(&m_ring));
+    }
+
+    // Provides the kernel with count buffers of buffer_size bytes, identified by group.
+    // count must be a power of 2.
+    // As for registered buffers, this should be called before run() or from the thread
+    // running the context.
+    std::error_code setup_buffer_ring(unsigned short group, unsigned count,
+                                      std::size_t buffer_size) {
+        int ret = 0;
+        auto ring = io_uring_setup_buf_ring(&m_ring, count, group, 0, &ret);
+        if(!ring) {
+            return register_result(ret);
+        }
+        m_buffer_rings.emplace_back(
+            new iouring::buffer_ring(&m_ring, ring, group, count, buffer_size));
+        return {};
+    }
+
+    // The ring set up for group, or nullptr
+    iouring::buffer_ring* buffer_ring(unsigned short group) noexcept {
+        for(auto& ring : m_buffer_rings) {
+            if(ring->group() == group) {
+                return ring.get();
+            }
+        }
+        return nullptr;
+    }
+
+private:
     struct io_uring m_ring;
     std::atomic_int m_notify_fd = -1;
     intrusive_mpsc_queue<iouring::operation_base> m_queue;
+    intrusive_mpsc_queue<iouring::cancel_request> m_cancels;
     std::atomic_bool m_notify = true;
+    // set while the thread running the context may be blocked waiting for completions,
+    // producers only signal the context when they clear it
+    std::atomic_bool m_sleeping = false;
+    // IORING_OP_MSG_RING is supported
+    bool m_msg_ring = false;
+    // operations completed by the thread running the context
+    std::size_t m_completed = 0;
     std::atomic_bool m_stopped = false;
+    std::atomic_uint64_t m_queued = 0;
+    std::uint64_t m_max_in_flight;
+    std::vector<std::unique_ptr<iouring::buffer_ring>> m_buffer_rings;
+
+    timer_wheel m_timers;
+    std::chrono::nanoseconds m_timer_resolution;
+    std::chrono::nanoseconds m_spin;
+    // the tick the kernel timeout is armed for, timer_wheel::never if it is not armed
+    timer_wheel::tick m_timer_armed = timer_wheel::never;
+    __kernel_timespec m_timer_ts;
 
-    void init() {
+    // only written by the thread running the context
+    struct counters {
+        std::atomic_uint64_t wakeups = 0;
+        std::atomic_uint64_t completions = 0;
+        std::atomic_uint64_t max_batch = 0;
+        std::array<std::atomic_uint64_t, io_uring_statistics::histogram_size> batch_histogram{};
+        std::atomic_uint64_t in_flight = 0;
+        std::atomic_uint64_t timers = 0;
+        std::atomic_uint64_t sq_full = 0;
+        std::atomic_uint64_t cq_backlogged = 0;
+        std::atomic_uint64_t submit_errors = 0;
+        // in nanoseconds
+        std::atomic_uint64_t spinning = 0;
+        std::atomic_uint64_t sleeping = 0;
+
+        static void add(std::atomic_uint64_t& counter, std::uint64_t n) noexcept {
+            counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+        static void sub(std::atomic_uint64_t& counter, std::uint64_t n) noexcept {
+            counter.store(counter.load(std::memory_order_relaxed) - n, std::memory_order_relaxed);
+        }
+    } m_counters;
+
+    void init(const io_uring_options& options) {
         m_notify_fd = ::eventfd(0, O_NONBLOCK);
         if(m_notify_fd < 0) {
             fprintf(stderr, "ring setup failed %d %s\n", errno, strerror(errno));
         }
 
-        auto ret = io_uring_queue_init(URING_ENTRIES, &m_ring, 0);
+        struct io_uring_params params = {};
+        if(options.cq_entries) {
+            params.flags |= IORING_SETUP_CQSIZE;
+            params.cq_entries = options.cq_entries;
+        }
+        if(options.sqpoll) {
+            params.flags |= IORING_SETUP_SQPOLL;
+            params.sq_thread_idle = options.sqpoll_idle.count();
+            if(options.sqpoll_cpu >= 0) {
+                params.flags |= IORING_SETUP_SQ_AFF;
+                params.sq_thread_cpu = options.sqpoll_cpu;
+            }
+        }
+        if(options.coop_taskrun) {
+            params.flags |= IORING_SETUP_COOP_TASKRUN;
+        }
+        if(options.defer_taskrun) {
+            params.flags |= IORING_SETUP_DEFER_TASKRUN;
+        }
+        if(options.single_issuer || options.defer_taskrun) {
+            // The ring is created disabled so that it can be owned by the thread calling run()
+            // rather than by the one constructing the context.
+            params.flags |= IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_R_DISABLED;
+        }
+
+        auto ret = io_uring_queue_init_params(options.sq_entries, &m_ring, &params);
         if(ret) {
             fprintf(stderr, "ring setup failed %d %s\n", ret, strerror(-ret));
             std::terminate();
         }
+        if(!(m_ring.features & IORING_FEAT_NODROP)) {
+            fprintf(stderr, "io_uring: completions may be dropped when the completion queue "
+                            "is full, consider lowering max_in_flight\n");
+        }
+        m_max_in_flight = options.max_in_flight ? options.max_in_flight : m_ring.cq.ring_entries;
+        if(auto probe = io_uring_get_probe_ring(&m_ring)) {
+            m_msg_ring = io_uring_opcode_supported(probe, IORING_OP_MSG_RING);
+            io_uring_free_probe(probe);
+        }
+        m_timer_resolution = options.timer_resolution;
+        m_spin = options.spin;
+    }
+
+    static std::chrono::nanoseconds to_duration(const __kernel_timespec& ts) noexcept {
+        return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+    }
+
+    static __kernel_timespec to_kernel_timespec(std::chrono::nanoseconds d) noexcept {
+        const auto secs = std::chrono::duration_cast<std::chrono::seconds>(d);
+        return {secs.count(), (d - secs).count()};
+    }
+
+    static std::error_code register_result(int ret) noexcept {
+        if(ret < 0) {
+            return std::make_error_code(std::errc(-ret));
+        }
+        return {};
     }
 
     void enqueue_operation(iouring::operation_base* op) {
         if(m_stopped) {
-            op->set_done();
+            // once reset, the stop callback has either run to completion or never will
+            op->m_stop_callback.reset();
+            if(!op->m_stop_requested.load(std::memory_order_acquire)) {
+                op->cancel_now();
+                return;
+            }
+            // its cancel_request is queued and the operation must outlive it, it is completed
+            // with set_done once the context processed the request, as any queued operation
         }
+        m_queued.fetch_add(1, std::memory_order_relaxed);
         m_queue.push(op);
         notify();
     }
-    void notify() {
+    void enqueue_cancel(iouring::cancel_request* request) {
+        m_cancels.push(request);
+        notify();
+    }
+    // Wakes up the context after something was queued, if it is waiting for completions.
+    // Wakeups coalesce: whatever the number of producers, the context is signaled at most
+    // once each time it goes to sleep.
+    void notify() noexcept {
+        // pairs with the fence in submit_and_wait
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(m_sleeping.load(std::memory_order_relaxed) &&
+           m_sleeping.exchange(false, std::memory_order_relaxed)) {
+            signal();
+        }
+    }
+
+    void signal() noexcept {
+        // a thread running another context posts a completion to this one directly,
+        // rather than going through the eventfd
+        auto producer = current();
+        if(producer && producer != this && producer->m_msg_ring && producer->post_wakeup(this)) {
+            return;
+        }
         eventfd_write(m_notify_fd, 1);
     }
 
-    void schedule_queue_read() {
+    bool post_wakeup(io_uring_context* target) noexcept {
+        // this may run in the middle of process_completions, which get_sqe must not reenter
+        if(io_uring_sq_space_left(&m_ring) == 0) {
+            return false;
+        }
         auto sqe = io_uring_get_sqe(&m_ring);
+        // submitted with the next batch of this context, before it waits
+        io_uring_prep_msg_ring(sqe, target->m_ring.ring_fd, 0, uint64_t(&target->m_queue), 0);
+        sqe->flags |= IOSQE_CQE_SKIP_SUCCESS;
+        sqe->user_data = 0;
+        return true;
+    }
+
+    // The context run by the calling thread, if any
+    static io_uring_context*& current() noexcept {
+        static thread_local io_uring_context* ctx = nullptr;
+        return ctx;
+    }
+
+    // Makes the calling thread the one running the context, for the duration of run or poll
+    class running {
+    public:
+        running(io_uring_context* ctx) : m_ctx(ctx), m_previous(std::exchange(current(), ctx)) {
+            ctx->enable();
+            ctx->m_sleeping.store(false, std::memory_order_relaxed);
+        }
+        ~running() {
+            // wakeups posted to other contexts by post_wakeup are only prepared,
+            // they would be lost if the caller stops driving this context
+            if(io_uring_sq_ready(&m_ctx->m_ring)) {
+                io_uring_submit(&m_ctx->m_ring);
+            }
+            current() = m_previous;
+            if(!m_ctx->m_stopped) {
+                // The caller is not running the loop anymore, and may wait on a registered
+                // eventfd. Make sure work queued from now on wakes it up.
+                m_ctx->m_sleeping.store(true, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if(m_ctx->has_pending_work() && m_ctx->m_sleeping.exchange(false)) {
+                    m_ctx->signal();
+                }
+            }
+        }
+
+    private:
+        io_uring_context* m_ctx;
+        io_uring_context* m_previous;
+    };
+
+    void enable() {
+        if(m_ring.flags & IORING_SETUP_R_DISABLED) {
+            // single issuer rings belong to the thread which enables them
+            auto ret = io_uring_enable_rings(&m_ring);
+            if(ret) {
+                fprintf(stderr, "ring setup failed %d %s\n", ret, strerror(-ret));
+                std::terminate();
+            }
+            m_ring.flags &= ~IORING_SETUP_R_DISABLED;
+        }
+    }
+
+    // One iteration of the loop, returns the number of operations completed.
+    // If wait is set, blocks until there are completions or timeout expires
+    std::size_t run_once(bool wait, __kernel_timespec* timeout = nullptr) noexcept {
+        const auto completed = m_completed;
+        schedule_pendings();
+        arm_timer();
+        if(wait) {
+            submit_and_wait(timeout);
+        } else {
+            io_uring_submit(&m_ring);
+            // submit does not enter the kernel when nothing is queued
+            get_events();
+        }
+        process_completions();
+        expire_timers();
+        return m_completed - completed;
+    }
+
+    // Submits and waits for completions in a single syscall.
+    // Does not wait if there is work queued, in which case no producer would signal us.
+    // Time spent spinning counts against timeout.
+    void submit_and_wait(__kernel_timespec* timeout) noexcept {
+        if(m_spin.count()) {
+            const auto limit = timeout ? std::min(m_spin, to_duration(*timeout)) : m_spin;
+            const auto start = std::chrono::steady_clock::now();
+            if(spin(limit)) {
+                return;
+            }
+            if(timeout) {
+                const auto spun = std::chrono::steady_clock::now() - start;
+                const auto left = to_duration(*timeout) -
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(spun);
+                if(left <= std::chrono::nanoseconds(0)) {
+                    return;
+                }
+                *timeout = to_kernel_timespec(left);
+            }
+        }
+        m_sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const bool pending = has_pending_work();
+        const auto start = std::chrono::steady_clock::now();
+        int ret;
+        if(timeout && !pending) {
+            io_uring_cqe* cqe;
+            ret = io_uring_submit_and_wait_timeout(&m_ring, &cqe, 1, timeout, nullptr);
+        } else {
+            ret = io_uring_submit_and_wait(&m_ring, pending ? 0 : 1);
+        }
+        if(ret < 0 && ret != -EINTR && ret != -ETIME) {
+            counters::add(m_counters.submit_errors, 1);
+        }
+        m_sleeping.store(false, std::memory_order_relaxed);
+        if(!pending) {
+            counters::add(m_counters.sleeping,
+                          (std::chrono::steady_clock::now() - start) / std::chrono::nanoseconds(1));
+        }
+    }
+
+    // Submits, then polls for completions or queued work without syscalls, for up to limit.
+    // Returns false if there is nothing to process and the loop should block.
+    bool spin(std::chrono::nanoseconds limit) noexcept {
+        auto ret = io_uring_submit(&m_ring);
+        if(ret < 0 && ret != -EINTR) {
+            counters::add(m_counters.submit_errors, 1);
+        }
+        const auto start = std::chrono::steady_clock::now();
+        auto now = start;
+        bool ready = false;
+        while(!ready && now - start < limit) {
+            get_events();
+            ready = io_uring_cq_ready(&m_ring) || has_pending_work() || m_stopped;
+            if(!ready) {
+                __spin_yield();
+            }
+            now = std::chrono::steady_clock::now();
+        }
+        counters::add(m_counters.spinning, (now - start) / std::chrono::nanoseconds(1));
+        return ready;
+    }
+
+    // With DEFER_TASKRUN, or when the kernel flags pending task work, completions are only
+    // posted once the thread enters the kernel. io_uring_get_events does, without waiting
+    void get_events() noexcept {
+        if((m_ring.flags & IORING_SETUP_DEFER_TASKRUN) ||
+           (__atomic_load_n(m_ring.sq.kflags, __ATOMIC_RELAXED) & IORING_SQ_TASKRUN)) {
+            io_uring_get_events(&m_ring);
+        }
+    }
+
+    // Operations or cancellations which can be submitted right away
+    bool has_pending_work() noexcept {
+        return m_cancels.front() ||
+            (m_queue.front() &&
+             m_counters.in_flight.load(std::memory_order_relaxed) < m_max_in_flight);
+    }
+
+    // Returns a submission entry, flushing the submission queue to the kernel when there is
+    // not room for count entries, so that linked entries can be obtained with further calls.
+    // Returns nullptr if the kernel cannot accept more submissions for now.
+    io_uring_sqe* get_sqe(unsigned count = 1) noexcept {
+        if(io_uring_sq_space_left(&m_ring) < count) {
+            flush_submissions();
+            if(io_uring_sq_space_left(&m_ring) < count) {
+                return nullptr;
+            }
+        }
+        return io_uring_get_sqe(&m_ring);
+    }
+
+    void flush_submissions() noexcept {
+        counters::add(m_counters.sq_full, 1);
+        auto ret = io_uring_submit(&m_ring);
+        if(ret == -EBUSY || ret == -EAGAIN) {
+            // The kernel is holding completions it could not post (IORING_FEAT_NODROP).
+            // Make room in the completion queue so they can be flushed, then try again.
+            counters::add(m_counters.cq_backlogged, 1);
+            process_completions();
+            io_uring_submit(&m_ring);
+        }
+    }
+
+    void schedule_queue_read() {
+        auto sqe = get_sqe();
         if(!sqe) {
-            std::cout << "No sqe\n\n";
-            // Queue full - not m_notifysure what we should do
+            // try again on the next iteration
+            return;
         }
-        io_uring_prep_poll_add(sqe, m_notify_fd, POLLIN);
+        // stays armed across wakeups, until the kernel posts a completion without F_MORE
+        io_uring_prep_poll_multishot(sqe, m_notify_fd, POLLIN);
         sqe->user_data = uint64_t(this);
         m_notify = false;
     }
 
+    void process_completions() noexcept {
+        unsigned head;
+        unsigned count = 0;
+        struct io_uring_cqe* cqe;
+        io_uring_for_each_cqe(&m_ring, head, cqe) {
+            process_completion(cqe);
+            count++;
+        }
+        if(count == 0) {
+            return;
+        }
+        // hand the whole batch back to the kernel at once
+        io_uring_cq_advance(&m_ring, count);
+
+        counters::add(m_counters.wakeups, 1);
+        counters::add(m_counters.completions, count);
+        if(count > m_counters.max_batch.load(std::memory_order_relaxed)) {
+            m_counters.max_batch.store(count, std::memory_order_relaxed);
+        }
+        auto bucket = std::min<std::size_t>(31 - __builtin_clz(count),
+                                            io_uring_statistics::histogram_size - 1);
+        counters::add(m_counters.batch_histogram[bucket], 1);
+    }
+
+    void process_completion(const io_uring_cqe* const cqe) noexcept {
+        if(cqe->user_data == 0 || cqe->user_data == LIBURING_UDATA_TIMEOUT) {
+            // ignore, maybe a cancel operation ?
+            // or the timeout of io_uring_submit_and_wait_timeout, on older kernels
+        } else if(cqe->user_data == uint64_t(&m_timers)) {
+            // the kernel timeout of the timer wheel fired or was cancelled,
+            // expired timers are handled by expire_timers
+            m_timer_armed = timer_wheel::never;
+        } else if(cqe->user_data == uint64_t(this)) {
+            uint64_t c;
+            eventfd_read(m_notify_fd, &c);
+            if(!(cqe->flags & IORING_CQE_F_MORE)) {
+                m_notify = true;
+            }
+        } else if(cqe->user_data == uint64_t(&m_queue)) {
+            // IORING_OP_MSG_RING wakeup from another context
+        } else {
+            auto op = reinterpret_cast<iouring::operation_base*>(cqe->user_data);
+            // multishot operations stay in flight until their last completion
+            if(!(cqe->flags & IORING_CQE_F_MORE)) {
+                counters::sub(m_counters.in_flight, 1);
+            }
+            m_completed++;
+            op->complete(cqe);
+        }
+    }
+
+    // Moves a timer operation from the queue to the timer wheel.
+    // Returns false if it needs a kernel timeout.
+    bool add_timer(iouring::timer_operation* op) noexcept {
+        const auto& d = op->m_deadline;
+        const auto flags = timeout_flags(d);
+        // Only monotonic deadlines can be handled by the wheel. Wall clock deadlines must
+        // follow changes of the system time, and linked timeouts need the operation in the kernel.
+        if(m_timer_resolution.count() == 0 || !d || op->m_timeout ||
+           (flags != 0 && flags != IORING_TIMEOUT_ABS)) {
+            return false;
+        }
+        m_queue.pop();
+        m_queued.fetch_sub(1, std::memory_order_relaxed);
+
+        const auto ts = to_timespec(d);
+        std::chrono::nanoseconds expiry =
+            std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+        if(flags == 0) {
+            expiry += std::chrono::steady_clock::now().time_since_epoch();
+        }
+        // round up, so that timers never fire early
+        const timer_wheel::tick tick = (expiry + m_timer_resolution - std::chrono::nanoseconds(1)) /
+            m_timer_resolution;
+        m_timers.advance(current_tick(), [this](timer_wheel::node* n) { fire_timer(n); });
+        if(tick <= m_timers.now()) {
+            m_completed++;
+            complete_timer(op);
+        } else {
+            m_timers.insert(op, tick);
+            counters::add(m_counters.timers, 1);
+        }
+        return true;
+    }
+
+    timer_wheel::tick current_tick() const noexcept {
+        return std::chrono::steady_clock::now().time_since_epoch() / m_timer_resolution;
+    }
+
+    void expire_timers() noexcept {
+        if(m_timers.empty()) {
+            return;
+        }
+        m_timers.advance(current_tick(), [this](timer_wheel::node* n) { fire_timer(n); });
+    }
+
+    void fire_timer(timer_wheel::node* n) noexcept {
+        counters::sub(m_counters.timers, 1);
+        m_completed++;
+        complete_timer(static_cast<iouring::timer_operation*>(n));
+    }
+
+    static void complete_timer(iouring::timer_operation* op) noexcept {
+        io_uring_cqe cqe = {};
+        cqe.user_data = uint64_t(static_cast<iouring::operation_base*>(op));
+        cqe.res = -ETIME;
+        op->complete(&cqe);
+    }
+
+    // Makes sure a single kernel timeout is armed for the next event of the timer wheel
+    void arm_timer() noexcept {
+        const auto next = m_timers.next_event();
+        if(next == timer_wheel::never || next >= m_timer_armed) {
+            return;
+        }
+        auto sqe = get_sqe();
+        if(!sqe) {
+            return;
+        }
+        const std::chrono::nanoseconds at = next * m_timer_resolution;
+        const auto secs = std::chrono::duration_cast<std::chrono::seconds>(at);
+        m_timer_ts = {secs.count(), (at - secs).count()};
+        if(m_timer_armed == timer_wheel::never) {
+            io_uring_prep_timeout(sqe, &m_timer_ts, 0, IORING_TIMEOUT_ABS);
+            sqe->user_data = uint64_t(&m_timers);
+        } else {
+            // move the armed timeout earlier rather than arming a second one
+            io_uring_prep_timeout_update(sqe, &m_timer_ts, uint64_t(&m_timers), IORING_TIMEOUT_ABS);
+            sqe->user_data = 0;
+        }
+        m_timer_armed = next;
+    }
+
+    // Handles the stop requests of operations, in the order they were made
+    void process_cancellations() noexcept {
+        while(auto request = m_cancels.front()) {
+            auto op = request->m_op;
+            if(op->m_completion_deferred) {
+                // the operation completed before the request was seen, deliver the result
+                op->m_cancel_processed = true;
+                m_cancels.pop();
+                io_uring_cqe cqe = {};
+                cqe.user_data = uint64_t(op);
+                cqe.res = op->m_deferred_res;
+                cqe.flags = op->m_deferred_flags;
+                op->set_result(&cqe);
+                continue;
+            }
+            if(op->m_is_timer && static_cast<iouring::timer_operation*>(op)->linked()) {
+                m_cancels.pop();
+                op->m_cancel_processed = true;
+                m_timers.remove(static_cast<iouring::timer_operation*>(op));
+                counters::sub(m_counters.timers, 1);
+                m_completed++;
+                op->cancel_now();
+                continue;
+            }
+            if(op->m_submitted) {
+                auto sqe = get_sqe();
+                if(!sqe) {
+                    // try again on the next iteration
+                    return;
+                }
+                if(op->m_completion_deferred) {
+                    // get_sqe may flush the ring and reap the completion of op,
+                    // which is then delivered above
+                    io_uring_prep_nop(sqe);
+                    sqe->user_data = 0;
+                    continue;
+                }
+                // the operation completes with -ECANCELED, or with its result
+                // if it was too late to cancel it
+                io_uring_prep_cancel(sqe, op, 0);
+                sqe->user_data = 0;
+            } else {
+                // still in the queue, it will be completed when it is dequeued
+                op->m_cancelled = true;
+            }
+            m_cancels.pop();
+            op->m_cancel_processed = true;
+        }
+    }
+
     void schedule_pendings() {
-        while(iouring::operation_base* op = m_queue.front()) {
-            // check cqe size too
-            auto sqe = io_uring_get_sqe(&m_ring);
+        if(m_notify) {
+            schedule_queue_read();
+        }
+        process_cancellations();
+        // Operations above the in-flight limit stay in the queue until completions come back,
+        // so that the completion queue cannot overflow
+        while(m_counters.in_flight.load(std::memory_order_relaxed) < m_max_in_flight) {
+            iouring::operation_base* op = m_queue.front();
+            if(!op) {
+                break;
+            }
+            if(op->m_cancelled) {
+                m_queue.pop();
+                m_queued.fetch_sub(1, std::memory_order_relaxed);
+                m_completed++;
+                op->cancel_now();
+                continue;
+            }
+            if(op->m_is_timer && add_timer(static_cast<iouring::timer_operation*>(op))) {
+                continue;
+            }
+            const bool linked_timeout = bool(op->m_timeout);
+            auto sqe = get_sqe(linked_timeout ? 2 : 1);
             if(!sqe) {
-                // Queue full
                 break;
             }
             op->prepare(sqe);
+            op->m_submitted = true;
             sqe->user_data = uint64_t(op);
-            m_queue.pop();
-            if(m_notify) {
-                schedule_queue_read();
-                m_notify = false;
+            if(linked_timeout) {
+                sqe->flags |= IOSQE_IO_LINK;
+                op->m_timeout_ts = to_timespec(op->m_timeout);
+                auto timeout_sqe = get_sqe();
+                io_uring_prep_link_timeout(timeout_sqe, &op->m_timeout_ts,
+                                           timeout_flags(op->m_timeout));
+                timeout_sqe->user_data = 0;
             }
+            m_queue.pop();
+            m_queued.fetch_sub(1, std::memory_order_relaxed);
+            counters::add(m_counters.in_flight, 1);
         }
     }
 };
 
 namespace iouring {
-    void operation_base::start() noexcept {
+    inline void operation_base::start() noexcept {
+        if(m_stop_token.stop_requested()) {
+            set_done();
+            return;
+        }
+        watch_stop_token();
         m_ctx->enqueue_operation(this);
     }
+    inline void operation_base::resubmit() noexcept {
+        if(m_stop_requested.load(std::memory_order_acquire)) {
+            set_done();
+            return;
+        }
+        m_submitted = false;
+        watch_stop_token();
+        m_ctx->enqueue_operation(this);
+    }
+    inline void operation_base::stop_request::operator()() noexcept {
+        m_op->m_stop_requested.store(true, std::memory_order_release);
+        m_op->m_ctx->enqueue_cancel(&m_op->m_cancel_request);
+    }
 }  // namespace iouring
 
 }  // namespace cor3ntin::corio
@@ -0,0 +1,79 @@
+#pragma once
+#include <corio/io_uring/base.hpp>
+
+namespace cor3ntin::corio::iouring::accept {
+template <typename R>
+class operation;
+class sender : public base_sender {
+    template <typename R>
+    friend class operation;
+    friend io_uring_context;
+
+public:
+    sender(io_uring_context* ctx, file_handle fd, sockaddr* address, socklen_t* address_size,
+           int flags)
+        : base_sender(ctx)
+        , m_fd(fd)
+        , m_address(address)
+        , m_address_size(address_size)
+        , m_flags(flags) {}
+
+    template <template <typename...> class Variant, template <typename...> class Tuple>
+    using value_types = Variant<Tuple<native_file_handle>>;
+
+    template <template <typename...> class Variant>
+    using error_types = Variant<std::error_code>;
+
+    static constexpr bool sends_done = true;
+
+    template <typename Sender, execution::receiver<std::error_code> R>
+    using operation_type = operation<R>;
+
+    template <execution::receiver<std::error_code> R>
+    auto connect(R&& r) && {
+        return operation(std::move(*this), std::forward<R>(r));
+    }
+
+private:
+    file_handle m_fd;
+    sockaddr* m_address;
+    socklen_t* m_address_size;
+    int m_flags;
+};
+template <typename R>
+class operation : public operation_base {
+    friend sender;
+    friend io_uring_context;
+    friend operation_base;
+
+public:
+    operation(sender s, R&& r)
+        : operation_base(s, execution::get_stop_token(r), &handle<operation>)
+        , m_sender(std::move(s))
+        , m_receiver(std::move(r)) {}
+
+
+protected:
+    void set_result(const io_uring_cqe* const cqe) noexcept {
+        if(cqe->res >= 0) {
+            execution::set_value(std::move(m_receiver), native_file_handle(cqe->res));
+        } else {
+            set_failure(std::move(m_receiver), cqe->res);
+        }
+    }
+
+    void set_done() noexcept {
+        execution::set_done(std::move(m_receiver));
+    }
+
+    void prepare(io_uring_sqe* const sqe) noexcept {
+        io_uring_prep_accept(sqe, m_sender.m_fd.fd(), m_sender.m_address, m_sender.m_address_size,
+                             m_sender.m_flags);
+        m_sender.m_fd.apply(sqe);
+    }
+
+private:
+    sender m_sender;
+    R m_receiver;
+};
+}  // namespace cor3ntin::corio::iouring::accept
@@ -0,0 +1,85 @@
+#pragma once
+#include <corio/io_uring/base.hpp>
+
+namespace cor3ntin::corio::iouring::accept_multishot {
+template <typename F, typename R>
+class operation;
+
+// Accepts connections until cancelled, f is called with the descriptor of each connection.
+// The sender only completes when accepting stops, with set_done when stopped,
+// or with timed_out when its timeout expires.
+template <typename F>
+class sender : public base_sender {
+    template <typename, typename>
+    friend class operation;
+    friend io_uring_context;
+
+public:
+    sender(io_uring_context* ctx, file_handle fd, F f, int flags)
+        : base_sender(ctx), m_fd(fd), m_f(std::move(f)), m_flags(flags) {}
+
+    template <template <typename...> class Variant, template <typename...> class Tuple>
+    using value_types = Variant<Tuple<>>;
+
+    template <template <typename...> class Variant>
+    using error_types = Variant<std::error_code>;
+
+    static constexpr bool sends_done = true;
+
+    template <typename Sender, execution::receiver<std::error_code> R>
+    using operation_type = operation<F, R>;
+
+    template <execution::receiver<std::error_code> R>
+    auto connect(R&& r) && {
+        return operation<F, std::remove_cvref_t<R>>(std::move(*this), std::forward<R>(r));
+    }
+
+private:
+    file_handle m_fd;
+    F m_f;
+    int m_flags;
+};
+template <typename F, typename R>
+class operation : public operation_base {
+    friend sender<F>;
+    friend io_uring_context;
+    friend operation_base;
+
+public:
+    operation(sender<F> s, R&& r)
+        : operation_base(s, execution::get_stop_token(r), &handle<operation>)
+        , m_sender(std::move(s))
+        , m_receiver(std::move(r)) {}
+
+
+protected:
+    void set_result(const io_uring_cqe* const cqe) noexcept {
+        const bool more = cqe->flags & IORING_CQE_F_MORE;
+        if(cqe->res >= 0) {
+            m_sender.m_f(native_file_handle(cqe->res));
+            if(!more) {
+                // the kernel stopped the multishot request, arm it again
+                resubmit();
+            }
+        } else if(more) {
+            // a single accept failed, the request is still armed
+        } else {
+            set_failure(std::move(m_receiver), cqe->res);
+        }
+    }
+
+    void set_done() noexcept {
+        execution::set_done(std::move(m_receiver));
+    }
+
+    void prepare(io_uring_sqe* const sqe) noexcept {
+        io_uring_prep_multishot_accept(sqe, m_sender.m_fd.fd(), nullptr, nullptr,
+                                       m_sender.m_flags);
+        m_sender.m_fd.apply(sqe);
+    }
+
+private:
+    sender<F> m_sender;
+    R m_receiver;
+};
+}  // namespace cor3ntin::corio::iouring::accept_multishot
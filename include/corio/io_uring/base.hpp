@@ -4,52 +4,245 @@
 #include <sys/poll.h>
 #include <fcntl.h>
 #include <liburing.h>
+#include <optional>
+#include <span>
 #include <corio/concepts.hpp>
 #include <corio/deadline.hpp>
+#include <corio/timeout.hpp>
 #include <corio/intrusive_linked_list.hpp>
+#include <corio/timer_wheel.hpp>
 
 namespace cor3ntin::corio {
 class io_uring_context;
 
-__kernel_timespec to_timespec(const deadline& d) {
+inline __kernel_timespec to_timespec(const deadline& d) {
     auto duration = d.d;
     auto secs = duration_cast<std::chrono::seconds>(duration);
     duration -= secs;
     return {secs.count(), duration.count()};
 }
 
+// the IORING_TIMEOUT_* flags selecting how the kernel interprets to_timespec(d)
+inline unsigned timeout_flags(const deadline& d) {
+    if(!d.absolute) {
+        return 0;
+    }
+    switch(d.c) {
+        case deadline::clock::realtime: return IORING_TIMEOUT_ABS | IORING_TIMEOUT_REALTIME;
+        case deadline::clock::boottime: return IORING_TIMEOUT_ABS | IORING_TIMEOUT_BOOTTIME;
+        default: return IORING_TIMEOUT_ABS;
+    }
+}
+
 namespace iouring {
     using native_file_handle = int;
     class scheduler;
 
+    // offset for read and write operations to use and update the file position,
+    // like read(2) and write(2) rather than pread(2) and pwrite(2)
+    inline constexpr std::uint64_t current_position = std::uint64_t(-1);
+
+    // A slot in the registered file table of an io_uring_context
+    // see io_uring_context::register_files
+    struct registered_file {
+        unsigned index;
+    };
+
+    // Either a plain file descriptor or a registered file.
+    // Registered files spare the kernel the lookup and reference counting of the
+    // descriptor on each operation.
+    class file_handle {
+    public:
+        file_handle(native_file_handle fd) noexcept : m_fd(fd), m_registered(false) {}
+        file_handle(registered_file f) noexcept : m_fd(int(f.index)), m_registered(true) {}
+
+        int fd() const noexcept {
+            return m_fd;
+        }
+        bool registered() const noexcept {
+            return m_registered;
+        }
+        // must be called after io_uring_prep_*, which reset the flags
+        void apply(io_uring_sqe* const sqe) const noexcept {
+            if(m_registered) {
+                sqe->flags |= IOSQE_FIXED_FILE;
+            }
+        }
+
+    private:
+        int m_fd;
+        bool m_registered;
+    };
+
+    class operation_base;
+
     class base_sender {
     public:
         base_sender(io_uring_context* ctx) : m_ctx(ctx) {}
         base_sender(const base_sender&) = delete;
         base_sender(base_sender&&) noexcept = default;
 
+        // The operation is submitted linked to an IORING_OP_LINK_TIMEOUT,
+        // if the deadline expires first, the kernel cancels it and
+        // the receiver gets std::errc::timed_out
+        template <typename Sender>
+        requires std::is_base_of_v<base_sender, Sender>  //
+            friend Sender tag_invoke(tag_t<corio::timeout>, Sender s, deadline d) noexcept {
+            s.m_timeout = d;
+            return s;
+        }
+
     protected:
+        friend operation_base;
         io_uring_context* m_ctx;
+        deadline m_timeout;
+    };
+
+    // Queued to the context when the stop token of an operation is triggered,
+    // the context then cancels the operation from the thread running it
+    class cancel_request : public intrusive_mpsc_queue_node {
+        friend operation_base;
+        friend io_uring_context;
+        operation_base* m_op;
     };
 
     class operation_base : public intrusive_mpsc_queue_node {
         friend intrusive_mpsc_queue_node;
         friend io_uring_context;
 
+    protected:
+        enum class event { result, done, prepare };
+        // A single entry point to the set_result, set_done and prepare functions of the
+        // derived operation, so that the state carries neither a vtable pointer nor a table
+        // of functions and a completion costs one direct call through m_handler
+        using handler = void (*)(operation_base*, event, const io_uring_cqe* const,
+                                 io_uring_sqe* const) noexcept;
+
+        template <typename Op>
+        static void handle(operation_base* op, event e, const io_uring_cqe* const cqe,
+                           io_uring_sqe* const sqe) noexcept {
+            auto self = static_cast<Op*>(op);
+            switch(e) {
+                case event::result: self->set_result(cqe); break;
+                case event::done: self->set_done(); break;
+                case event::prepare: self->prepare(sqe); break;
+            }
+        }
+
     public:
-        operation_base(io_uring_context* ctx) : m_ctx(ctx) {}
+        // token is the stop token of the receiver, the operation is cancelled when it is triggered.
+        // h is handle<Op> for the most derived type Op
+        operation_base(const base_sender& s, stop_token token, handler h)
+            : m_ctx(s.m_ctx), m_timeout(s.m_timeout), m_handler(h), m_stop_token(std::move(token)) {
+            m_cancel_request.m_op = this;
+        }
         // the state is neither copyable nor movable
         operation_base(const operation_base&) = delete;
         operation_base(operation_base&&) = delete;
-        virtual void start() noexcept;
+        void start() noexcept;
 
     protected:
         io_uring_context* m_ctx;
-        virtual void set_result(const io_uring_cqe* const res) noexcept = 0;
-        virtual void set_done() noexcept = 0;
-        virtual void prepare(io_uring_sqe* const sqe) noexcept = 0;
+        deadline m_timeout;
+        __kernel_timespec m_timeout_ts;
+
+        // Delivers a failed result to the receiver
+        template <typename R>
+        void set_failure(R&& receiver, int res) noexcept {
+            if(res == -ECANCELED && m_stop_requested.load(std::memory_order_relaxed)) {
+                execution::set_done((R &&) receiver);
+            } else if(res == -ECANCELED && m_timeout) {
+                execution::set_error((R &&) receiver, std::make_error_code(std::errc::timed_out));
+            } else {
+                execution::set_error((R &&) receiver, std::make_error_code(std::errc(-res)));
+            }
+        }
+
+        // Submits the operation again, for multishot operations the kernel stopped
+        void resubmit() noexcept;
+
+        // set for timer_operation
+        bool m_is_timer = false;
 
     private:
+        handler m_handler;
+
+        void set_result(const io_uring_cqe* const cqe) noexcept {
+            m_handler(this, event::result, cqe, nullptr);
+        }
+        void set_done() noexcept {
+            m_handler(this, event::done, nullptr, nullptr);
+        }
+        void prepare(io_uring_sqe* const sqe) noexcept {
+            m_handler(this, event::prepare, nullptr, sqe);
+        }
+
+        struct stop_request {
+            operation_base* m_op;
+            void operator()() noexcept;
+        };
+
+        stop_token m_stop_token;
+        std::optional<stop_callback<stop_request>> m_stop_callback;
+        std::atomic_bool m_stop_requested = false;
+        cancel_request m_cancel_request;
+
+        // only accessed by the thread running the context
+        bool m_submitted = false;
+        // the context has seen m_cancel_request, the operation can complete
+        bool m_cancel_processed = false;
+        // the cancellation was seen before the operation was submitted
+        bool m_cancelled = false;
+        // the operation completed while its cancellation was still queued,
+        // the result is delivered once the context has seen the request
+        bool m_completion_deferred = false;
+        int m_deferred_res = 0;
+        unsigned m_deferred_flags = 0;
+
+        void watch_stop_token() noexcept {
+            if(m_stop_token.stop_possible()) {
+                m_stop_callback.emplace(m_stop_token, stop_request{this});
+            }
+        }
+
+        // Called by the context with each completion of the operation
+        void complete(const io_uring_cqe* const cqe) noexcept {
+            if(!(cqe->flags & IORING_CQE_F_MORE)) {
+                // once reset, the callback has either run to completion or never will
+                m_stop_callback.reset();
+                if(m_stop_requested.load(std::memory_order_acquire) && !m_cancel_processed) {
+                    // the context still holds m_cancel_request, the operation
+                    // must outlive it
+                    m_completion_deferred = true;
+                    m_deferred_res = cqe->res;
+                    m_deferred_flags = cqe->flags;
+                    return;
+                }
+            }
+            set_result(cqe);
+        }
+
+        // Completes an operation which is not in the kernel with set_done
+        void cancel_now() noexcept {
+            m_stop_callback.reset();
+            set_done();
+        }
+    };
+
+    // An operation completed by a timeout, which the context can complete from its timer wheel
+    // rather than by submitting a kernel timeout.
+    // When it does, set_result is called with -ETIME, as it would be by the kernel.
+    class timer_operation : public operation_base, public timer_wheel::node {
+        friend io_uring_context;
+
+    public:
+        timer_operation(const base_sender& s, deadline d, stop_token token, handler h)
+            : operation_base(s, std::move(token), h), m_deadline(d) {
+            m_is_timer = true;
+        }
+
+    protected:
+        deadline m_deadline;
     };
 }  // namespace iouring
 }  // namespace cor3ntin::corio
\ No newline at end of file
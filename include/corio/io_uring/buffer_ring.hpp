@@ -0,0 +1,63 @@
+#pragma once
+#include <memory>
+#include <corio/io_uring/base.hpp>
+
+namespace cor3ntin::corio::iouring {
+
+// A ring of buffers provided to the kernel, see io_uring_context::setup_buffer_ring.
+// Operations using the ring do not need a buffer of their own while they wait for data:
+// the kernel picks one when data arrives and reports its id in the completion.
+class buffer_ring {
+    friend io_uring_context;
+
+public:
+    buffer_ring(const buffer_ring&) = delete;
+    buffer_ring(buffer_ring&&) = delete;
+    ~buffer_ring() {
+        io_uring_free_buf_ring(m_uring, m_ring, m_count, m_group);
+    }
+
+    unsigned short group() const noexcept {
+        return m_group;
+    }
+
+    std::size_t buffer_size() const noexcept {
+        return m_buffer_size;
+    }
+
+    void* buffer(unsigned short id) noexcept {
+        return m_storage.get() + std::size_t(id) * m_buffer_size;
+    }
+
+    // gives a buffer back to the kernel once its content has been consumed
+    void recycle(unsigned short id) noexcept {
+        io_uring_buf_ring_add(m_ring, buffer(id), m_buffer_size, id,
+                              io_uring_buf_ring_mask(m_count), 0);
+        io_uring_buf_ring_advance(m_ring, 1);
+    }
+
+private:
+    buffer_ring(io_uring* uring, io_uring_buf_ring* ring, unsigned short group, unsigned count,
+                std::size_t buffer_size)
+        : m_uring(uring)
+        , m_ring(ring)
+        , m_group(group)
+        , m_count(count)
+        , m_buffer_size(buffer_size)
+        , m_storage(new std::byte[std::size_t(count) * buffer_size]) {
+        for(unsigned id = 0; id < count; id++) {
+            io_uring_buf_ring_add(m_ring, buffer(id), m_buffer_size, id,
+                                  io_uring_buf_ring_mask(m_count), id);
+        }
+        io_uring_buf_ring_advance(m_ring, count);
+    }
+
+    io_uring* m_uring;
+    io_uring_buf_ring* m_ring;
+    unsigned short m_group;
+    unsigned m_count;
+    std::size_t m_buffer_size;
+    std::unique_ptr<std::byte[]> m_storage;
+};
+
+}  // namespace cor3ntin::corio::iouring
@@ -35,21 +35,24 @@ template <typename R>
 class operation : public operation_base {
     friend sender;
     friend io_uring_context;
+    friend operation_base;
 
 public:
     operation(sender s, R&& r)
-        : operation_base(s.m_ctx), m_sender(std::move(s)), m_receiver(std::move(r)) {}
+        : operation_base(s, execution::get_stop_token(r), &handle<operation>)
+        , m_sender(std::move(s))
+        , m_receiver(std::move(r)) {}
 
 protected:
-    void set_result(const io_uring_cqe* const cqe) noexcept override {
-        if(cqe->res >= 0) {
-            execution::set_value(m_receiver);
-        }
+    void set_result(const io_uring_cqe* const) noexcept {
+        // -ENOENT and -EALREADY mean the operation completed or is about to,
+        // either way there is nothing left to cancel
+        execution::set_value(std::move(m_receiver));
     }
-    void set_done() noexcept override {
-        // cancelled the cancel operation ?
+    void set_done() noexcept {
+        execution::set_done(std::move(m_receiver));
     }
-    void prepare(io_uring_sqe* const sqe) noexcept override {
+    void prepare(io_uring_sqe* const sqe) noexcept {
         io_uring_prep_cancel(sqe, (void*)(m_sender.m_op), 0);
     }
 
@@ -10,8 +10,9 @@ class sender : public base_sender {
     friend io_uring_context;
 
 public:
-    sender(io_uring_context* ctx, native_file_handle fd, void* buffer, std::size_t size)
-        : base_sender(ctx), m_fd(fd), m_buffer(buffer), m_size(size) {}
+    sender(io_uring_context* ctx, file_handle fd, void* buffer, std::size_t size,
+           std::uint64_t offset)
+        : base_sender(ctx), m_fd(fd), m_buffer(buffer), m_size(size), m_offset(offset) {}
 
     template <template <typename...> class Variant, template <typename...> class Tuple>
     using value_types = Variant<Tuple<std::size_t>>;
@@ -29,39 +30,46 @@ public:
         return operation(std::move(*this), std::forward<R>(r));
     }
 
-    native_file_handle m_fd;
+private:
+    file_handle m_fd;
     void* m_buffer;
     std::size_t m_size;
+    std::uint64_t m_offset;
 };
 template <typename R>
 class operation : public operation_base {
     friend sender;
     friend io_uring_context;
+    friend operation_base;
 
 public:
     operation(sender s, R&& r)
-        : operation_base(s.m_ctx), m_sender(std::move(s)), m_receiver(std::move(r)) {}
+        : operation_base(s, execution::get_stop_token(r), &handle<operation>)
+        , m_sender(std::move(s))
+        , m_receiver(std::move(r)) {}
 
 
 protected:
-    void set_result(const io_uring_cqe* const cqe) noexcept override {
-        if(cqe->res > 0) {
-            execution::set_value(m_receiver, cqe->res);
+    void set_result(const io_uring_cqe* const cqe) noexcept {
+        if(cqe->res >= 0) {
+            execution::set_value(std::move(m_receiver), std::size_t(cqe->res));
         } else {
-            execution::set_error(m_receiver, std::make_error_code(std::errc(-cqe->res)));
+            set_failure(std::move(m_receiver), cqe->res);
         }
     }
 
-    void set_done() noexcept override {
-        execution::set_done(m_receiver);
+    void set_done() noexcept {
+        execution::set_done(std::move(m_receiver));
     }
 
-    void prepare(io_uring_sqe* const sqe) noexcept override {
-        io_uring_prep_read(sqe, m_sender.m_fd, m_sender.m_buffer, m_sender.m_size, 0);
+    void prepare(io_uring_sqe* const sqe) noexcept {
+        io_uring_prep_read(sqe, m_sender.m_fd.fd(), m_sender.m_buffer, m_sender.m_size,
+                           m_sender.m_offset);
+        m_sender.m_fd.apply(sqe);
     }
 
 private:
-    R m_receiver;
     sender m_sender;
+    R m_receiver;
 };
-}  // namespace cor3ntin::corio::iouring::read
\ No newline at end of file
+}  // namespace cor3ntin::corio::iouring::read
@@ -0,0 +1,99 @@
+#pragma once
+#include <corio/io_uring/base.hpp>
+#include <corio/io_uring/buffer_ring.hpp>
+
+namespace cor3ntin::corio::iouring::recv_multishot {
+template <typename F, typename R>
+class operation;
+
+// Receives until the peer shuts down the connection, f is called with each chunk of data
+// as f(const void* data, std::size_t size). The data lives in a buffer taken from buffers,
+// which is given back to the kernel when f returns.
+// The sender completes with set_value when the connection is shut down, and like other
+// senders with set_done when stopped, or with timed_out when its timeout expires.
+template <typename F>
+class sender : public base_sender {
+    template <typename, typename>
+    friend class operation;
+    friend io_uring_context;
+
+public:
+    sender(io_uring_context* ctx, file_handle fd, buffer_ring& buffers, F f, int flags)
+        : base_sender(ctx), m_fd(fd), m_buffers(&buffers), m_f(std::move(f)), m_flags(flags) {}
+
+    template <template <typename...> class Variant, template <typename...> class Tuple>
+    using value_types = Variant<Tuple<>>;
+
+    template <template <typename...> class Variant>
+    using error_types = Variant<std::error_code>;
+
+    static constexpr bool sends_done = true;
+
+    template <typename Sender, execution::receiver<std::error_code> R>
+    using operation_type = operation<F, R>;
+
+    template <execution::receiver<std::error_code> R>
+    auto connect(R&& r) && {
+        return operation<F, std::remove_cvref_t<R>>(std::move(*this), std::forward<R>(r));
+    }
+
+private:
+    file_handle m_fd;
+    buffer_ring* m_buffers;
+    F m_f;
+    int m_flags;
+};
+template <typename F, typename R>
+class operation : public operation_base {
+    friend sender<F>;
+    friend io_uring_context;
+    friend operation_base;
+
+public:
+    operation(sender<F> s, R&& r)
+        : operation_base(s, execution::get_stop_token(r), &handle<operation>)
+        , m_sender(std::move(s))
+        , m_receiver(std::move(r)) {}
+
+
+protected:
+    void set_result(const io_uring_cqe* const cqe) noexcept {
+        const bool more = cqe->flags & IORING_CQE_F_MORE;
+        if(cqe->flags & IORING_CQE_F_BUFFER) {
+            const auto id = static_cast<unsigned short>(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+            if(cqe->res > 0) {
+                m_sender.m_f(static_cast<const void*>(m_sender.m_buffers->buffer(id)),
+                             std::size_t(cqe->res));
+            }
+            m_sender.m_buffers->recycle(id);
+        }
+        if(more) {
+            return;
+        }
+        if(cqe->res > 0 || cqe->res == -ENOBUFS) {
+            // the kernel stopped the multishot request, either because it ran out
+            // of buffers or for its own reasons, arm it again
+            resubmit();
+        } else if(cqe->res == 0) {
+            execution::set_value(std::move(m_receiver));
+        } else {
+            set_failure(std::move(m_receiver), cqe->res);
+        }
+    }
+
+    void set_done() noexcept {
+        execution::set_done(std::move(m_receiver));
+    }
+
+    void prepare(io_uring_sqe* const sqe) noexcept {
+        io_uring_prep_recv_multishot(sqe, m_sender.m_fd.fd(), nullptr, 0, m_sender.m_flags);
+        sqe->flags |= IOSQE_BUFFER_SELECT;
+        sqe->buf_group = m_sender.m_buffers->group();
+        m_sender.m_fd.apply(sqe);
+    }
+
+private:
+    sender<F> m_sender;
+    R m_receiver;
+};
+}  // namespace cor3ntin::corio::iouring::recv_multishot
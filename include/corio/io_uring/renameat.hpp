@@ -0,0 +1,83 @@
+#pragma once
+#include <corio/io_uring/base.hpp>
+#include <string>
+
+namespace cor3ntin::corio::iouring::renameat {
+template <typename R>
+class operation;
+
+// The paths are copied, so that they outlive the submission
+class sender : public base_sender {
+    template <typename R>
+    friend class operation;
+    friend io_uring_context;
+
+public:
+    sender(io_uring_context* ctx, int old_dir, std::string old_path, int new_dir,
+           std::string new_path, unsigned flags)
+        : base_sender(ctx)
+        , m_old_dir(old_dir)
+        , m_old_path(std::move(old_path))
+        , m_new_dir(new_dir)
+        , m_new_path(std::move(new_path))
+        , m_flags(flags) {}
+
+    template <template <typename...> class Variant, template <typename...> class Tuple>
+    using value_types = Variant<Tuple<>>;
+
+    template <template <typename...> class Variant>
+    using error_types = Variant<std::error_code>;
+
+    static constexpr bool sends_done = true;
+
+    template <typename Sender, execution::receiver<std::error_code> R>
+    using operation_type = operation<R>;
+
+    template <execution::receiver<std::error_code> R>
+    auto connect(R&& r) && {
+        return operation(std::move(*this), std::forward<R>(r));
+    }
+
+private:
+    int m_old_dir;
+    std::string m_old_path;
+    int m_new_dir;
+    std::string m_new_path;
+    unsigned m_flags;
+};
+template <typename R>
+class operation : public operation_base {
+    friend sender;
+    friend io_uring_context;
+    friend operation_base;
+
+public:
+    operation(sender s, R&& r)
+        : operation_base(s, execution::get_stop_token(r), &handle<operation>)
+        , m_sender(std::move(s))
+        , m_receiver(std::move(r)) {}
+
+
+protected:
+    void set_result(const io_uring_cqe* const cqe) noexcept {
+        if(cqe->res >= 0) {
+            execution::set_value(std::move(m_receiver));
+        } else {
+            set_failure(std::move(m_receiver), cqe->res);
+        }
+    }
+
+    void set_done() noexcept {
+        execution::set_done(std::move(m_receiver));
+    }
+
+    void prepare(io_uring_sqe* const sqe) noexcept {
+        io_uring_prep_renameat(sqe, m_sender.m_old_dir, m_sender.m_old_path.c_str(),
+                               m_sender.m_new_dir, m_sender.m_new_path.c_str(), m_sender.m_flags);
+    }
+
+private:
+    sender m_sender;
+    R m_receiver;
+};
+}  // namespace cor3ntin::corio::iouring::renameat
@@ -32,28 +32,32 @@ public:
     }
 };
 template <typename R>
-class operation : public operation_base {
+class operation : public timer_operation {
     friend sender;
     friend io_uring_context;
+    friend operation_base;
     operation(sender s, R&& r)
-        : operation_base(s.m_ctx), m_sender(std::move(s)), m_receiver(std::move(r)) {}
+        : timer_operation(s, s.m_deadline, execution::get_stop_token(r), &handle<operation>)
+        , m_sender(std::move(s))
+        , m_receiver(std::move(r)) {}
 
 protected:
-    void set_result(const io_uring_cqe* const cqe) noexcept override {
+    void set_result(const io_uring_cqe* const cqe) noexcept {
         if(cqe->res >= 0 || cqe->res == -ETIME) {
-            execution::set_value(m_receiver);
+            execution::set_value(std::move(m_receiver));
+        } else {
+            execution::set_done(std::move(m_receiver));
         }
     }
-    virtual void set_done() noexcept override {
-        execution::set_done(m_receiver);
+    void set_done() noexcept {
+        execution::set_done(std::move(m_receiver));
     }
-    void prepare(io_uring_sqe* const sqe) noexcept override {
+    void prepare(io_uring_sqe* const sqe) noexcept {
         m_ts = to_timespec(m_sender.m_deadline);
-        // std::cout << "Deadline " << m_ts.tv_sec << " " << m_ts.tv_nsec << "\n";
-        if(m_ts.tv_sec == 0 && m_ts.tv_nsec == 0) {
+        if(!m_sender.m_deadline) {
             io_uring_prep_nop(sqe);
         } else {
-            io_uring_prep_timeout(sqe, &m_ts, 0, 0);
+            io_uring_prep_timeout(sqe, &m_ts, 0, timeout_flags(m_sender.m_deadline));
         }
     }
 
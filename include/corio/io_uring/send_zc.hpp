@@ -0,0 +1,94 @@
+#pragma once
+#include <corio/io_uring/base.hpp>
+
+namespace cor3ntin::corio::iouring::send_zc {
+template <typename R>
+class operation;
+
+// Payloads smaller than this are sent with a plain send, as pinning the pages
+// and waiting for the notification costs more than copying them
+inline constexpr std::size_t copy_threshold = 16 * 1024;
+
+// Sends without copying the buffer to the socket, the buffer must stay untouched until the
+// sender completes, which is only once the kernel has released it, not when the data was sent.
+// Requires Linux 6.0
+class sender : public base_sender {
+    template <typename R>
+    friend class operation;
+    friend io_uring_context;
+
+public:
+    sender(io_uring_context* ctx, file_handle fd, const void* buffer, std::size_t size, int flags)
+        : base_sender(ctx), m_fd(fd), m_buffer(buffer), m_size(size), m_flags(flags) {}
+
+    template <template <typename...> class Variant, template <typename...> class Tuple>
+    using value_types = Variant<Tuple<std::size_t>>;
+
+    template <template <typename...> class Variant>
+    using error_types = Variant<std::error_code>;
+
+    static constexpr bool sends_done = true;
+
+    template <typename Sender, execution::receiver<std::error_code> R>
+    using operation_type = operation<R>;
+
+    template <execution::receiver<std::error_code> R>
+    auto connect(R&& r) && {
+        return operation(std::move(*this), std::forward<R>(r));
+    }
+
+private:
+    file_handle m_fd;
+    const void* m_buffer;
+    std::size_t m_size;
+    int m_flags;
+};
+template <typename R>
+class operation : public operation_base {
+    friend sender;
+    friend io_uring_context;
+    friend operation_base;
+
+public:
+    operation(sender s, R&& r)
+        : operation_base(s, execution::get_stop_token(r), &handle<operation>)
+        , m_sender(std::move(s))
+        , m_receiver(std::move(r)) {}
+
+
+protected:
+    void set_result(const io_uring_cqe* const cqe) noexcept {
+        if(cqe->flags & IORING_CQE_F_MORE) {
+            // the result of the send, the kernel holds on the buffer until the notification
+            m_res = cqe->res;
+            return;
+        }
+        const int res = (cqe->flags & IORING_CQE_F_NOTIF) ? m_res : cqe->res;
+        if(res >= 0) {
+            execution::set_value(std::move(m_receiver), std::size_t(res));
+        } else {
+            set_failure(std::move(m_receiver), res);
+        }
+    }
+
+    void set_done() noexcept {
+        execution::set_done(std::move(m_receiver));
+    }
+
+    void prepare(io_uring_sqe* const sqe) noexcept {
+        if(m_sender.m_size < copy_threshold) {
+            io_uring_prep_send(sqe, m_sender.m_fd.fd(), m_sender.m_buffer, m_sender.m_size,
+                               m_sender.m_flags);
+        } else {
+            io_uring_prep_send_zc(sqe, m_sender.m_fd.fd(), m_sender.m_buffer, m_sender.m_size,
+                                  m_sender.m_flags, 0);
+        }
+        m_sender.m_fd.apply(sqe);
+    }
+
+private:
+    sender m_sender;
+    R m_receiver;
+    int m_res = 0;
+};
+}  // namespace cor3ntin::corio::iouring::send_zc
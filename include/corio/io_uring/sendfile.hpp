@@ -0,0 +1,131 @@
+#pragma once
+#include <corio/io_uring/base.hpp>
+
+namespace cor3ntin::corio::iouring::sendfile {
+template <typename R>
+class operation;
+
+// Bytes moved by each splice, the default capacity of a pipe
+inline constexpr unsigned chunk_size = 64 * 1024;
+
+// Sends size bytes of file, starting at offset, to socket, or until the end of the file.
+// The data is spliced from the file to an internal pipe and from the pipe to the socket,
+// so that it never reaches user memory.
+// Sends the number of bytes transferred.
+class sender : public base_sender {
+    template <typename R>
+    friend class operation;
+    friend io_uring_context;
+
+public:
+    sender(io_uring_context* ctx, file_handle file, file_handle socket, std::uint64_t offset,
+           std::size_t size)
+        : base_sender(ctx), m_file(file), m_socket(socket), m_offset(offset), m_size(size) {}
+
+    template <template <typename...> class Variant, template <typename...> class Tuple>
+    using value_types = Variant<Tuple<std::size_t>>;
+
+    template <template <typename...> class Variant>
+    using error_types = Variant<std::error_code>;
+
+    static constexpr bool sends_done = true;
+
+    template <typename Sender, execution::receiver<std::error_code> R>
+    using operation_type = operation<R>;
+
+    template <execution::receiver<std::error_code> R>
+    auto connect(R&& r) && {
+        return operation(std::move(*this), std::forward<R>(r));
+    }
+
+private:
+    file_handle m_file;
+    file_handle m_socket;
+    std::uint64_t m_offset;
+    std::size_t m_size;
+};
+template <typename R>
+class operation : public operation_base {
+    friend sender;
+    friend io_uring_context;
+    friend operation_base;
+
+public:
+    operation(sender s, R&& r)
+        : operation_base(s, execution::get_stop_token(r), &handle<operation>)
+        , m_sender(std::move(s))
+        , m_receiver(std::move(r)) {}
+
+    ~operation() {
+        if(m_pipe[0] >= 0) {
+            ::close(m_pipe[0]);
+            ::close(m_pipe[1]);
+        }
+    }
+
+    void start() noexcept {
+        if(::pipe2(m_pipe, O_CLOEXEC) < 0) {
+            m_pipe[0] = m_pipe[1] = -1;
+            execution::set_error(std::move(m_receiver), std::make_error_code(std::errc(errno)));
+            return;
+        }
+        operation_base::start();
+    }
+
+protected:
+    void set_result(const io_uring_cqe* const cqe) noexcept {
+        if(cqe->res < 0) {
+            set_failure(std::move(m_receiver), cqe->res);
+            return;
+        }
+        const auto n = std::size_t(cqe->res);
+        if(m_in_pipe == 0) {
+            // file to pipe, 0 is the end of the file
+            if(n == 0) {
+                execution::set_value(std::move(m_receiver), m_sent);
+                return;
+            }
+            m_in_pipe = n;
+            m_read += n;
+        } else {
+            // pipe to socket
+            m_in_pipe -= n;
+            m_sent += n;
+            if(m_in_pipe == 0 && m_read == m_sender.m_size) {
+                execution::set_value(std::move(m_receiver), m_sent);
+                return;
+            }
+        }
+        resubmit();
+    }
+
+    void set_done() noexcept {
+        execution::set_done(std::move(m_receiver));
+    }
+
+    void prepare(io_uring_sqe* const sqe) noexcept {
+        if(m_in_pipe == 0) {
+            const auto offset = m_sender.m_offset == current_position ? current_position
+                                                                      : m_sender.m_offset + m_read;
+            const unsigned size = unsigned(std::min<std::size_t>(m_sender.m_size - m_read,
+                                                                 chunk_size));
+            const unsigned fixed_in = m_sender.m_file.registered() ? SPLICE_F_FD_IN_FIXED : 0;
+            io_uring_prep_splice(sqe, m_sender.m_file.fd(), std::int64_t(offset), m_pipe[1], -1,
+                                 size, SPLICE_F_MOVE | fixed_in);
+        } else {
+            io_uring_prep_splice(sqe, m_pipe[0], -1, m_sender.m_socket.fd(), -1,
+                                 unsigned(m_in_pipe), SPLICE_F_MOVE);
+            m_sender.m_socket.apply(sqe);
+        }
+    }
+
+private:
+    sender m_sender;
+    R m_receiver;
+    int m_pipe[2] = {-1, -1};
+    // bytes read from the file, sent to the socket, and waiting in the pipe
+    std::size_t m_read = 0;
+    std::size_t m_sent = 0;
+    std::size_t m_in_pipe = 0;
+};
+}  // namespace cor3ntin::corio::iouring::sendfile
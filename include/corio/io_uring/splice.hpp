@@ -0,0 +1,86 @@
+#pragma once
+#include <corio/io_uring/base.hpp>
+
+namespace cor3ntin::corio::iouring::splice {
+template <typename R>
+class operation;
+class sender : public base_sender {
+    template <typename R>
+    friend class operation;
+    friend io_uring_context;
+
+public:
+    sender(io_uring_context* ctx, file_handle in, std::uint64_t in_offset, file_handle out,
+           std::uint64_t out_offset, unsigned size, unsigned flags)
+        : base_sender(ctx)
+        , m_in(in)
+        , m_in_offset(in_offset)
+        , m_out(out)
+        , m_out_offset(out_offset)
+        , m_size(size)
+        , m_flags(flags) {}
+
+    template <template <typename...> class Variant, template <typename...> class Tuple>
+    using value_types = Variant<Tuple<std::size_t>>;
+
+    template <template <typename...> class Variant>
+    using error_types = Variant<std::error_code>;
+
+    static constexpr bool sends_done = true;
+
+    template <typename Sender, execution::receiver<std::error_code> R>
+    using operation_type = operation<R>;
+
+    template <execution::receiver<std::error_code> R>
+    auto connect(R&& r) && {
+        return operation(std::move(*this), std::forward<R>(r));
+    }
+
+private:
+    file_handle m_in;
+    std::uint64_t m_in_offset;
+    file_handle m_out;
+    std::uint64_t m_out_offset;
+    unsigned m_size;
+    unsigned m_flags;
+};
+template <typename R>
+class operation : public operation_base {
+    friend sender;
+    friend io_uring_context;
+    friend operation_base;
+
+public:
+    operation(sender s, R&& r)
+        : operation_base(s, execution::get_stop_token(r), &handle<operation>)
+        , m_sender(std::move(s))
+        , m_receiver(std::move(r)) {}
+
+
+protected:
+    void set_result(const io_uring_cqe* const cqe) noexcept {
+        if(cqe->res >= 0) {
+            execution::set_value(std::move(m_receiver), std::size_t(cqe->res));
+        } else {
+            set_failure(std::move(m_receiver), cqe->res);
+        }
+    }
+
+    void set_done() noexcept {
+        execution::set_done(std::move(m_receiver));
+    }
+
+    void prepare(io_uring_sqe* const sqe) noexcept {
+        const unsigned fixed_in = m_sender.m_in.registered() ? SPLICE_F_FD_IN_FIXED : 0;
+        io_uring_prep_splice(sqe, m_sender.m_in.fd(), std::int64_t(m_sender.m_in_offset),
+                             m_sender.m_out.fd(), std::int64_t(m_sender.m_out_offset),
+                             m_sender.m_size, m_sender.m_flags | fixed_in);
+        // applies to the output
+        m_sender.m_out.apply(sqe);
+    }
+
+private:
+    sender m_sender;
+    R m_receiver;
+};
+}  // namespace cor3ntin::corio::iouring::splice
@@ -0,0 +1,132 @@
+#pragma once
+#include <corio/affinity.hpp>
+#include <corio/io_uring.hpp>
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace cor3ntin::corio {
+
+// How io_uring_pool::pool_scheduler picks the context work is sent to
+enum class placement {
+    // each schedule() goes to the next context
+    round_robin,
+    // each schedule() goes to the context with the fewest queued and in-flight operations
+    least_loaded
+};
+
+// N io_uring_contexts, each run by its own thread pinned to its own cpu.
+// Work on a context stays on that context's thread, so a coroutine that needs to be on a
+// given shard, to use a registered file or buffer for example, moves there with
+// co_await pool.transfer(shard).
+class io_uring_pool {
+public:
+    class pool_scheduler {
+    public:
+        iouring::schedule::sender schedule() const noexcept {
+            return shard().schedule();
+        }
+
+        // The scheduler of the context the next schedule() would go to,
+        // io operations must be started from a context's own scheduler
+        iouring::scheduler shard() const noexcept {
+            return m_pool->pick(m_placement).scheduler();
+        }
+
+    private:
+        friend io_uring_pool;
+        pool_scheduler(io_uring_pool* pool, placement p) : m_pool(pool), m_placement(p) {}
+
+        io_uring_pool* m_pool;
+        placement m_placement;
+    };
+
+    // Runs n contexts, pinned to the first n cpus the calling thread is allowed to run on.
+    // If there are fewer cpus than contexts, or if pin is false, the threads are not pinned.
+    // There is at least one context, hardware_concurrency() may be 0.
+    explicit io_uring_pool(std::size_t n = std::thread::hardware_concurrency(),
+                           io_uring_options options = {}, bool pin = true) {
+        n = std::max<std::size_t>(n, 1);
+        const auto cpus = available_cpus();
+        pin = pin && cpus.size() >= n;
+        m_contexts.reserve(n);
+        for(std::size_t i = 0; i < n; i++) {
+            m_contexts.emplace_back(new io_uring_context(options));
+        }
+        m_threads.reserve(n);
+        for(std::size_t i = 0; i < n; i++) {
+            const int cpu = pin ? int(cpus[i]) : -1;
+            m_threads.emplace_back([this, i, cpu] {
+                if(cpu >= 0) {
+                    pin_current_thread(unsigned(cpu));
+                }
+                m_contexts[i]->run(m_stop.get_token());
+            });
+        }
+    }
+
+    io_uring_pool(const io_uring_pool&) = delete;
+    io_uring_pool& operator=(const io_uring_pool&) = delete;
+
+    ~io_uring_pool() {
+        stop();
+    }
+
+    // Stops all contexts and waits for their threads
+    void stop() {
+        m_stop.request_stop();
+        for(auto&& t : m_threads) {
+            if(t.joinable()) {
+                t.join();
+            }
+        }
+    }
+
+    std::size_t size() const noexcept {
+        return m_contexts.size();
+    }
+
+    io_uring_context& context(std::size_t shard) noexcept {
+        return *m_contexts[shard];
+    }
+
+    pool_scheduler scheduler(placement p = placement::round_robin) noexcept {
+        return pool_scheduler(this, p);
+    }
+
+    // The scheduler of the context owning key, which is always the same for a given key.
+    // Use it to keep everything related to a connection, keyed by its hash, on one shard.
+    iouring::scheduler scheduler_for(std::uint64_t key) noexcept {
+        return m_contexts[key % m_contexts.size()]->scheduler();
+    }
+
+    // co_await pool.transfer(shard) resumes the coroutine on the thread running that shard
+    iouring::schedule::sender transfer(std::size_t shard) noexcept {
+        return m_contexts[shard]->scheduler().schedule();
+    }
+
+private:
+    io_uring_context& pick(placement p) noexcept {
+        if(p == placement::least_loaded) {
+            auto best = m_contexts.front().get();
+            auto best_load = best->load();
+            for(auto& ctx : m_contexts) {
+                const auto load = ctx->load();
+                if(load < best_load) {
+                    best = ctx.get();
+                    best_load = load;
+                }
+            }
+            return *best;
+        }
+        return *m_contexts[m_next.fetch_add(1, std::memory_order_relaxed) % m_contexts.size()];
+    }
+
+    std::vector<std::unique_ptr<io_uring_context>> m_contexts;
+    std::vector<std::thread> m_threads;
+    stop_source m_stop;
+    std::atomic_size_t m_next = 0;
+};
+
+}  // namespace cor3ntin::corio
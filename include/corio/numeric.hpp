@@ -0,0 +1,222 @@
+#pragma once
+#include <corio/bulk.hpp>
+#include <corio/concepts.hpp>
+#include <corio/then.hpp>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace cor3ntin::corio {
+
+// Parallel versions of the algorithms of <numeric>, as senders running on a scheduler.
+// The input is split in at most a few ranges per hardware thread, of at least grain elements,
+// each range is folded by a call of bulk into its own accumulator, and the accumulators are
+// then combined. The operations must be associative, and may be called concurrently.
+
+namespace details {
+
+    inline constexpr std::size_t default_grain = 4096;
+
+    // Accumulators written by different threads do not share a cache line
+    template <typename T>
+    struct alignas(64) padded {
+        std::optional<T> value;
+    };
+
+    inline std::size_t partition_count(std::size_t n, std::size_t grain) {
+        const std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+        return std::min((n + grain - 1) / std::max<std::size_t>(grain, 1), threads * 4);
+    }
+
+    // Range k of count equal ranges covering [0, n)
+    inline std::pair<std::size_t, std::size_t> partition(std::size_t n, std::size_t count,
+                                                         std::size_t k) {
+        return {k * n / count, (k + 1) * n / count};
+    }
+
+    // Combines neighbours pairwise, then neighbouring pairs, and so on,
+    // which bounds the rounding error of floating point sums by the log of the count.
+    // v must not be empty
+    template <typename T, typename Op>
+    T tree_combine(std::vector<padded<T>>& v, Op& op) {
+        for(std::size_t stride = 1; stride < v.size(); stride *= 2) {
+            for(std::size_t i = 0; i + stride < v.size(); i += 2 * stride) {
+                v[i].value = op(std::move(*v[i].value), std::move(*v[i + stride].value));
+            }
+        }
+        return std::move(*v[0].value);
+    }
+
+    template <typename First, typename Second, typename R>
+    class sequence_operation;
+
+    // Starts Second once First sent a value, and sends the result of Second.
+    // Both send std::exception_ptr as their error.
+    template <typename First, typename Second>
+    class sequence_sender {
+    public:
+        template <template <typename...> class Variant, template <typename...> class Tuple>
+        using value_types = typename Second::template value_types<Variant, Tuple>;
+
+        template <template <typename...> class Variant>
+        using error_types = Variant<std::exception_ptr>;
+
+        static constexpr bool sends_done = true;
+
+        template <typename Sender, execution::receiver R>
+        using operation_type = sequence_operation<First, Second, R>;
+
+        sequence_sender(First first, Second second)
+            : m_first(std::move(first)), m_second(std::move(second)) {}
+
+        template <execution::receiver R>
+        auto connect(R&& r) && {
+            return sequence_operation<First, Second, std::remove_cvref_t<R>>(
+                std::move(m_first), std::move(m_second), std::forward<R>(r));
+        }
+
+    private:
+        First m_first;
+        Second m_second;
+    };
+
+    template <typename First, typename Second, typename R>
+    class sequence_operation {
+        template <bool IsFirst>
+        struct step_receiver {
+            sequence_operation* m_op;
+
+            template <typename... Values>
+            void set_value(Values&&... values) noexcept {
+                if constexpr(IsFirst)
+                    execution::start(m_op->m_second);
+                else
+                    execution::set_value(std::move(m_op->m_receiver), (Values &&) values...);
+            }
+            template <typename Error>
+            void set_error(Error&& error) noexcept {
+                execution::set_error(std::move(m_op->m_receiver), (Error &&) error);
+            }
+            void set_done() noexcept {
+                execution::set_done(std::move(m_op->m_receiver));
+            }
+            auto get_stop_token() const noexcept {
+                return execution::get_stop_token(m_op->m_receiver);
+            }
+        };
+
+    public:
+        sequence_operation(First first, Second second, R r)
+            : m_receiver(std::move(r))
+            , m_first(execution::connect(std::move(first), step_receiver<true>{this}))
+            , m_second(execution::connect(std::move(second), step_receiver<false>{this})) {}
+
+        void start() noexcept {
+            execution::start(m_first);
+        }
+
+    private:
+        R m_receiver;
+        decltype(execution::connect(std::declval<First>(), step_receiver<true>{})) m_first;
+        decltype(execution::connect(std::declval<Second>(), step_receiver<false>{})) m_second;
+    };
+
+}  // namespace details
+
+// Sends init combined by reduce with transform(x) for every x in [first, last)
+template <typename Scheduler, std::random_access_iterator It, typename T, typename Reduce,
+          typename Transform>
+auto transform_reduce(const Scheduler& sch, It first, It last, T init, Reduce reduce,
+                      Transform transform, std::size_t grain = details::default_grain) {
+    struct state {
+        It first;
+        std::size_t n;
+        T init;
+        Reduce reduce;
+        Transform transform;
+        std::vector<details::padded<T>> partials;
+    };
+    const auto n = std::size_t(last - first);
+    const auto count = details::partition_count(n, grain);
+    auto s = std::make_shared<state>(state{first, n, std::move(init), std::move(reduce),
+                                           std::move(transform),
+                                           std::vector<details::padded<T>>(count)});
+    return then(bulk(sch, count,
+                     [s](std::size_t k) {
+                         auto [i, end] = details::partition(s->n, s->partials.size(), k);
+                         T acc = s->transform(s->first[i]);
+                         for(++i; i < end; ++i)
+                             acc = s->reduce(std::move(acc), s->transform(s->first[i]));
+                         s->partials[k].value = std::move(acc);
+                     }),
+                [s]() -> T {
+                    if(s->partials.empty())
+                        return std::move(s->init);
+                    return s->reduce(std::move(s->init),
+                                     details::tree_combine(s->partials, s->reduce));
+                });
+}
+
+// Sends init combined by op with every element of [first, last)
+template <typename Scheduler, std::random_access_iterator It, typename T,
+          typename Op = std::plus<>>
+auto reduce(const Scheduler& sch, It first, It last, T init, Op op = {},
+            std::size_t grain = details::default_grain) {
+    return transform_reduce(sch, first, last, std::move(init), std::move(op), std::identity{},
+                            grain);
+}
+
+// Writes the inclusive prefix combinations by op of [first, last) to out, which may be first.
+// Sends the end of the output.
+// The sum of each range is computed by a first call of bulk, and a second one scans each
+// range again starting from the sum of the ranges before it
+template <typename Scheduler, std::random_access_iterator It, std::random_access_iterator Out,
+          typename Op = std::plus<>>
+auto inclusive_scan(const Scheduler& sch, It first, It last, Out out, Op op = {},
+                    std::size_t grain = details::default_grain) {
+    using T = std::iter_value_t<It>;
+    struct state {
+        It first;
+        Out out;
+        std::size_t n;
+        Op op;
+        std::vector<details::padded<T>> partials;
+    };
+    const auto n = std::size_t(last - first);
+    const auto count = details::partition_count(n, grain);
+    auto s = std::make_shared<state>(
+        state{first, out, n, std::move(op), std::vector<details::padded<T>>(count)});
+
+    auto sums = then(bulk(sch, count,
+                          [s](std::size_t k) {
+                              auto [i, end] = details::partition(s->n, s->partials.size(), k);
+                              T acc = s->first[i];
+                              for(++i; i < end; ++i)
+                                  acc = s->op(std::move(acc), s->first[i]);
+                              s->partials[k].value = std::move(acc);
+                          }),
+                     [s] {
+                         // partials[k] becomes the sum of the ranges up to k
+                         for(std::size_t k = 1; k < s->partials.size(); ++k)
+                             s->partials[k].value = s->op(*s->partials[k - 1].value,
+                                                          std::move(*s->partials[k].value));
+                     });
+    auto scans = then(bulk(sch, count,
+                           [s](std::size_t k) {
+                               auto [i, end] = details::partition(s->n, s->partials.size(), k);
+                               T acc = k == 0 ? T(s->first[i])
+                                              : T(s->op(*s->partials[k - 1].value, s->first[i]));
+                               s->out[i] = acc;
+                               for(++i; i < end; ++i) {
+                                   acc = s->op(std::move(acc), s->first[i]);
+                                   s->out[i] = acc;
+                               }
+                           }),
+                      [s] { return s->out + std::iter_difference_t<Out>(s->n); });
+    return details::sequence_sender(std::move(sums), std::move(scans));
+}
+
+}  // namespace cor3ntin::corio
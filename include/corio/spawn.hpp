@@ -24,6 +24,13 @@ namespace details {
                 m_op->m_receiver.set_done();
                 delete m_op;
             }
+            template <typename R = Receiver>
+            requires requires(const R& r) {
+                r.get_stop_token();
+            }
+            auto get_stop_token() const noexcept {
+                return m_op->m_receiver.get_stop_token();
+            }
         };
         spawned_op(Sender&& sender, Receiver&& receiver)
             : m_receiver((Receiver &&) receiver)
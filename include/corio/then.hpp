@@ -89,8 +89,16 @@ struct then_sender {
         void set_done() && noexcept {
             execution::set_done((Receiver &&) receiver_);
         }
+
+        auto get_stop_token() const noexcept {
+            return execution::get_stop_token(receiver_);
+        }
     };
 
+    template <typename Sender, typename Receiver>
+    using operation_type =
+        typename Predecessor::template operation_type<Predecessor, then_receiver<Receiver>>;
+
     template <typename Receiver>
     auto connect(Receiver&& receiver) && {
         return execution::connect(std::forward<Predecessor>(pred_),
@@ -1,13 +1,36 @@
 #pragma once
+#include <corio/affinity.hpp>
+#include <corio/bulk.hpp>
 #include <corio/concepts.hpp>
+#include <corio/work_stealing_deque.hpp>
 #include <vector>
 #include <vector>
 #include <thread>
 #include <queue>
 #include <exception>
+#include <mutex>
 
 namespace cor3ntin::corio {
 
+struct thread_pool_options {
+    // number of workers, 0 for one per cpu the pool may run on
+    std::size_t threads = 0;
+    // pin each worker to its own cpu, in the order of cpus, or of available_cpus() if empty.
+    // Workers are not pinned if there are fewer cpus than workers
+    bool pin = false;
+    std::vector<unsigned> cpus;
+    // pin the workers and group them by the numa node of their cpu, see static_thread_pool
+    bool numa = false;
+};
+
+// A pool of workers, each with its own deque of operations, which steal from each other
+// when idle.
+// Workers may be grouped by numa node. Operations scheduled through scheduler(node) from
+// outside of the node go to the injection queue of the node, which only its workers take from.
+// Operations scheduled by a worker go to its deque. Idle workers look for work in their node
+// first, and only steal from the deques of other nodes when there is nothing else, so work
+// of a node runs on it unless its workers are busy while others are idle.
+// scheduler() schedules to a queue shared by all workers.
 class static_thread_pool {
 
     class stp_scheduler;
@@ -33,8 +56,9 @@ class static_thread_pool {
 
 
     private:
-        task_sender(static_thread_pool& pool) : m_pool(pool) {}
+        task_sender(static_thread_pool& pool, std::size_t node) : m_pool(pool), m_node(node) {}
         static_thread_pool& m_pool;
+        std::size_t m_node;
 
     public:
         task_sender(const task_sender&) = delete;
@@ -49,41 +73,70 @@ class static_thread_pool {
     class operation_base {
         friend class static_thread_pool;
 
-        operation_base() = default;
+    protected:
+        enum class event { value, error, done };
+        using handler = void (*)(operation_base*, event) noexcept;
+
+        // h is handle<Op> for the most derived type Op,
+        // completing an operation is a direct call rather than a virtual one
+        operation_base(handler h) noexcept : m_handler(h) {}
         // the state is neither copyable nor movable
         operation_base(const operation_base&) = delete;
         operation_base(operation_base&&) = delete;
 
-    protected:
-        virtual void set_value() noexcept = 0;
-        virtual void set_error() noexcept = 0;
-        virtual void set_done() noexcept = 0;
+        template <typename Op>
+        static void handle(operation_base* op, event e) noexcept {
+            auto self = static_cast<Op*>(op);
+            switch(e) {
+                case event::value: self->set_value(); break;
+                case event::error: self->set_error(); break;
+                case event::done: self->set_done(); break;
+            }
+        }
+
         operation_base* m_next = nullptr;
+
+    private:
+        handler m_handler;
+
+        void set_value() noexcept {
+            m_handler(this, event::value);
+        }
+        void set_error() noexcept {
+            m_handler(this, event::error);
+        }
+        void set_done() noexcept {
+            m_handler(this, event::done);
+        }
     };
 
     template <typename R>
     class schedule_operation : public operation_base {
         friend class task_sender;
-        schedule_operation(task_sender s, R r) : m_sender(std::move(s)), m_receiver(std::move(r)) {}
+        friend operation_base;
+        schedule_operation(task_sender s, R r)
+            : operation_base(&handle<schedule_operation>)
+            , m_sender(std::move(s))
+            , m_receiver(std::move(r)) {}
 
         task_sender m_sender;
         R m_receiver;
 
 
     protected:
-        void set_value() noexcept override {
-            m_receiver.set_value();
+        void set_value() noexcept {
+            execution::set_value(std::move(m_receiver));
         }
-        void set_done() noexcept override {
-            m_receiver.set_done();
+        void set_done() noexcept {
+            execution::set_done(std::move(m_receiver));
         }
-        void set_error() noexcept override {
-            m_receiver.set_done();
+        void set_error() noexcept {
+            execution::set_done(std::move(m_receiver));
         }
 
     public:
         void start() noexcept {
-            m_sender.m_pool.execute(*this);
+            m_sender.m_pool.execute(*this, m_sender.m_node);
         }
     };
 
@@ -119,21 +172,24 @@ class static_thread_pool {
     template <execution::receiver R>
     class depleted_operation : public operation_base {
         friend class depleted_sender;
+        friend operation_base;
         depleted_operation(depleted_sender sender, R r)
-            : m_sender(std::move(sender)), m_receiver(std::move(r)) {}
+            : operation_base(&handle<depleted_operation>)
+            , m_sender(std::move(sender))
+            , m_receiver(std::move(r)) {}
 
         depleted_sender m_sender;
         R m_receiver;
 
     protected:
-        void set_value() noexcept override {
-            m_receiver.set_value();
+        void set_value() noexcept {
+            execution::set_value(std::move(m_receiver));
         }
-        void set_done() noexcept override {
-            m_receiver.set_done();
+        void set_done() noexcept {
+            execution::set_done(std::move(m_receiver));
         }
-        void set_error() noexcept override {
-            m_receiver.set_done();
+        void set_error() noexcept {
+            execution::set_done(std::move(m_receiver));
         }
 
     public:
@@ -143,131 +199,638 @@ class static_thread_pool {
     };
 
 
+    template <typename F, execution::receiver R>
+    class bulk_operation;
+
+    template <typename F>
+    class bulk_sender {
+    public:
+        template <template <typename...> class Variant, template <typename...> class Tuple>
+        using value_types = Variant<Tuple<>>;
+
+        template <template <typename...> class Variant>
+        using error_types = Variant<std::exception_ptr>;
+
+        static constexpr bool sends_done = true;
+
+        template <typename Sender, execution::receiver R>
+        using operation_type = bulk_operation<F, R>;
+
+        bulk_sender(const bulk_sender&) = delete;
+        bulk_sender(bulk_sender&&) = default;
+
+        template <execution::receiver R>
+        auto connect(R&& r) && {
+            return bulk_operation<F, std::remove_cvref_t<R>>(std::move(*this), std::forward<R>(r));
+        }
+
+    private:
+        template <typename, execution::receiver>
+        friend class bulk_operation;
+        friend class stp_scheduler;
+
+        bulk_sender(static_thread_pool& pool, std::size_t node, std::size_t n, F f)
+            : m_pool(pool), m_node(node), m_n(n), m_f(std::move(f)) {}
+
+        static_thread_pool& m_pool;
+        std::size_t m_node;
+        std::size_t m_n;
+        F m_f;
+    };
+
+    // [0, n) is split in a few contiguous ranges per worker, each range is an operation
+    // scheduled on the pool, and the last one to finish completes the receiver.
+    // Contiguous ranges keep neighbouring indices, and the cache lines they touch,
+    // on the same worker, while having more ranges than workers lets idle workers steal
+    template <typename F, execution::receiver R>
+    class bulk_operation {
+        static constexpr std::size_t chunks_per_worker = 4;
+
+        struct chunk : operation_base {
+            friend operation_base;
+            chunk() : operation_base(&handle<chunk>) {}
+
+            bulk_operation* m_op = nullptr;
+            std::size_t m_begin = 0;
+            std::size_t m_end = 0;
+
+        private:
+            void set_value() noexcept {
+                m_op->run(m_begin, m_end);
+            }
+            void set_done() noexcept {
+                m_op->m_cancelled.store(true, std::memory_order_relaxed);
+                m_op->finish();
+            }
+            void set_error() noexcept {
+                set_done();
+            }
+        };
+
+    public:
+        bulk_operation(bulk_sender<F> s, R r)
+            : m_pool(s.m_pool)
+            , m_node(s.m_node)
+            , m_n(s.m_n)
+            , m_f(std::move(s.m_f))
+            , m_receiver(std::move(r))
+            , m_count(std::min(m_n, m_pool.workers_of(m_node) * chunks_per_worker))
+            , m_chunks(new chunk[m_count]) {}
+
+        void start() noexcept {
+            if(m_count == 0) {
+                execution::set_value(std::move(m_receiver));
+                return;
+            }
+            m_remaining.store(m_count, std::memory_order_relaxed);
+            for(std::size_t i = 0; i < m_count; ++i) {
+                auto& c = m_chunks[i];
+                c.m_op = this;
+                c.m_begin = i * m_n / m_count;
+                c.m_end = (i + 1) * m_n / m_count;
+                c.m_next = i + 1 < m_count ? &m_chunks[i + 1] : nullptr;
+            }
+            m_pool.execute_all(&m_chunks[0], m_node);
+        }
+
+    private:
+        void run(std::size_t begin, std::size_t end) noexcept {
+            // once a call failed, the remaining ranges are skipped
+            if(!m_failed.load(std::memory_order_relaxed)) {
+                try {
+                    for(std::size_t i = begin; i < end; ++i)
+                        std::invoke(m_f, i);
+                } catch(...) {
+                    if(!m_failed.exchange(true, std::memory_order_relaxed))
+                        m_error = std::current_exception();
+                }
+            }
+            finish();
+        }
+
+        void finish() noexcept {
+            // acq_rel, so that the last one sees m_error and the effects of all calls
+            if(m_remaining.fetch_sub(1, std::memory_order_acq_rel) != 1)
+                return;
+            if(m_error)
+                execution::set_error(std::move(m_receiver), std::move(m_error));
+            else if(m_cancelled.load(std::memory_order_relaxed))
+                execution::set_done(std::move(m_receiver));
+            else
+                execution::set_value(std::move(m_receiver));
+        }
+
+        static_thread_pool& m_pool;
+        std::size_t m_node;
+        std::size_t m_n;
+        F m_f;
+        R m_receiver;
+        std::size_t m_count;
+        std::unique_ptr<chunk[]> m_chunks;
+        std::atomic_size_t m_remaining = 0;
+        std::atomic_bool m_failed = false;
+        std::atomic_bool m_cancelled = false;
+        std::exception_ptr m_error;
+    };
+
+
     class stp_scheduler {
     public:
         stp_scheduler(const stp_scheduler&) = delete;
         stp_scheduler(stp_scheduler&&) noexcept = default;
         task_sender schedule() const noexcept {
-            return task_sender(m_pool);
+            return task_sender(m_pool, m_node);
+        }
+
+        template <typename F>
+        friend auto tag_invoke(tag_t<corio::bulk>, const stp_scheduler& s, std::size_t n, F&& f) {
+            return s.make_bulk(n, (F &&) f);
         }
 
     private:
         friend class static_thread_pool;
-        stp_scheduler(static_thread_pool& pool) : m_pool(pool){};
+        stp_scheduler(static_thread_pool& pool, std::size_t node) : m_pool(pool), m_node(node){};
+
+        template <typename F>
+        bulk_sender<std::decay_t<F>> make_bulk(std::size_t n, F&& f) const {
+            return bulk_sender<std::decay_t<F>>(m_pool, m_node, n, (F &&) f);
+        }
 
 
         static_thread_pool& m_pool;
+        std::size_t m_node;
     };
 
 public:
-    static_thread_pool(std::size_t n) {
-        for(std::size_t i = 0; i < n; ++i)
-            m_threads.emplace_back([this] { attach(); });
+    // scheduler() schedules on any node
+    static constexpr std::size_t any_node = std::size_t(-1);
+
+    static_thread_pool(std::size_t n) : static_thread_pool(thread_pool_options{.threads = n}) {}
+
+    explicit static_thread_pool(thread_pool_options options) {
+        auto cpus = options.cpus.empty() ? available_cpus() : std::move(options.cpus);
+        const auto n = options.threads ? options.threads : std::max<std::size_t>(cpus.size(), 1);
+        const bool pin = (options.pin || options.numa) && cpus.size() >= n;
+
+        // the node of each worker, as an index in m_nodes
+        std::vector<std::size_t> node_of(n, 0);
+        if(pin && options.numa) {
+            const auto numa = numa_nodes();
+            // nodes without workers are left out, the others keep their order
+            std::vector<bool> used(numa.size());
+            for(std::size_t i = 0; i < n; ++i) {
+                const auto it = std::find_if(numa.begin(), numa.end(), [cpu = cpus[i]](auto& nd) {
+                    return std::binary_search(nd.cpus.begin(), nd.cpus.end(), cpu);
+                });
+                node_of[i] = it == numa.end() ? 0 : std::size_t(it - numa.begin());
+                used[node_of[i]] = true;
+            }
+            std::vector<std::size_t> index(numa.size());
+            for(std::size_t k = 0; k < numa.size(); ++k) {
+                index[k] = m_nodes.size();
+                if(used[k])
+                    m_nodes.emplace_back(new node);
+            }
+            for(auto& k : node_of)
+                k = index[k];
+        } else {
+            m_nodes.emplace_back(new node);
+        }
+
+        m_workers.reserve(n);
+        for(std::size_t i = 0; i < n; ++i) {
+            m_workers.emplace_back(new worker(i, node_of[i]));
+            m_nodes[node_of[i]]->m_workers.push_back(m_workers.back().get());
+        }
+        for(std::size_t i = 0; i < n; ++i) {
+            const int cpu = pin ? int(cpus[i]) : -1;
+            m_threads.emplace_back([this, i, cpu] {
+                if(cpu >= 0)
+                    pin_current_thread(unsigned(cpu));
+                attach(*m_workers[i]);
+            });
+        }
     }
 
 
-    void attach() {
-        std::unique_lock lock(m_mutex);
+    void stop() {
+        std::vector<operation_base*> injected;
+        operation_base* depleted;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_stopped = true;
+            for(std::size_t i = 0; i <= m_nodes.size(); ++i) {
+                auto& q = i < m_nodes.size() ? *m_nodes[i] : m_shared;
+                injected.push_back(std::exchange(q.m_head, nullptr));
+                q.m_tail = nullptr;
+                q.m_injected.store(0, std::memory_order_relaxed);
+            }
+            depleted = std::exchange(m_depleted_head, nullptr);
+            m_depleted_tail = nullptr;
+            while(unpark_locked(any_node))
+                ;
+        }
 
-        while(true) {
-            if(m_stopped)
-                return;
+        for(auto&& t : m_threads) {
+            if(t.joinable())
+                t.join();
+        }
+
+        // the workers are gone, what is left in their deques is ours
+        for(auto& w : m_workers) {
+            while(auto op = w->m_deque.pop())
+                op->set_done();
+        }
+        for(auto op : injected)
+            done_all(op);
+        done_all(depleted);
+    }
+
+    auto scheduler() noexcept {
+        return stp_scheduler(*this, any_node);
+    }
+
+    // Schedules on the workers of node, in [0, nodes())
+    auto scheduler(std::size_t node) noexcept {
+        return stp_scheduler(*this, node);
+    }
 
-            m_condition.wait(lock);
+    // Number of groups of workers, 1 unless the pool was created with options.numa.
+    // Nodes are in increasing order of numa node id
+    std::size_t nodes() const noexcept {
+        return m_nodes.size();
+    }
+
+    depleted_sender depleted() noexcept {
+        return depleted_sender(*this);
+    }
 
-            while(m_head) {
-                operation_base& op = *m_head;
-                m_head = m_head->m_next;
-                lock.unlock();
-                op.set_value();
-                lock.lock();
+
+    ~static_thread_pool() {
+        stop();
+    }
+
+private:
+    // Operations scheduled by a worker go to its own deque, where idle workers steal them.
+    // Operations scheduled from other threads go to the injection queue of a node.
+    struct worker {
+        // operations beyond that go to the injection queue
+        static constexpr std::size_t capacity = 4096;
+
+        worker(std::size_t index, std::size_t node)
+            : m_deque(capacity), m_rng(index * 0x9E3779B97F4A7C15ull + 1), m_node(node) {}
+
+        work_stealing_deque<operation_base> m_deque;
+        // xorshift state, to pick the victims of steal attempts
+        std::uint64_t m_rng;
+        std::size_t m_node;
+        // the parked worker waits for this to become 1
+        std::atomic<std::uint32_t> m_wake = 0;
+
+        std::size_t random() noexcept {
+            m_rng ^= m_rng << 13;
+            m_rng ^= m_rng >> 7;
+            m_rng ^= m_rng << 17;
+            return std::size_t(m_rng);
+        }
+    };
+
+    struct alignas(64) node {
+        // injection queue, guarded by m_mutex
+        operation_base* m_head = nullptr;
+        operation_base* m_tail = nullptr;
+        // its size, checked without the lock
+        std::atomic_size_t m_injected = 0;
+        // workers which can take from the queue, looking for work before they park
+        std::atomic_size_t m_spinning = 0;
+        std::vector<worker*> m_workers;
+    };
+
+    struct current_worker {
+        static_thread_pool* pool = nullptr;
+        worker* w = nullptr;
+    };
+    static current_worker& current() noexcept {
+        static thread_local current_worker c;
+        return c;
+    }
+
+    // number of operations moved from the injection queue to a worker's deque at once
+    static constexpr std::size_t injection_batch = 32;
+    // attempts to find work an idle worker makes before parking
+    static constexpr std::size_t spin_rounds = 64;
+
+    void attach(worker& w) {
+        current() = {this, &w};
+        while(true) {
+            if(auto op = find_work(w)) {
+                op->set_value();
+                continue;
             }
-            on_depleted();
-            continue;
+            if(!wait_for_work(w))
+                break;
         }
+        current() = {};
     }
 
+    // Looks in the node of w first. The injection queues of other nodes are left to their
+    // workers, only their deques are stolen from
+    operation_base* find_work(worker& w) noexcept {
+        if(auto op = w.m_deque.pop())
+            return op;
+        auto& home = *m_nodes[w.m_node];
+        if(auto op = take_injected(w, home))
+            return op;
+        if(auto op = take_injected(w, m_shared))
+            return op;
+        if(auto op = steal(w, home.m_workers))
+            return op;
+        for(auto& nd : m_nodes) {
+            if(nd.get() == &home)
+                continue;
+            if(auto op = steal(w, nd->m_workers))
+                return op;
+        }
+        return nullptr;
+    }
 
-    void stop() {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        m_stopped = true;
+    // Steals from random victims, then everyone in order so that no work is missed
+    static operation_base* steal(worker& w, const std::vector<worker*>& victims) noexcept {
+        const auto n = victims.size();
+        for(std::size_t i = 0; i < n; ++i) {
+            auto& victim = *victims[w.random() % n];
+            if(&victim == &w)
+                continue;
+            if(auto op = victim.m_deque.steal())
+                return op;
+        }
+        for(auto victim : victims) {
+            if(victim == &w)
+                continue;
+            if(auto op = victim->m_deque.steal())
+                return op;
+        }
+        return nullptr;
+    }
 
-        for(auto op = m_head; op; op = op->m_next) {
-            lock.unlock();
-            op->set_done();
-            lock.lock();
-            m_condition.notify_all();
+    // Takes the first operation injected in nd, and moves a few more to the deque of w
+    // so that they can be stolen without going through the lock again
+    operation_base* take_injected(worker& w, node& nd) noexcept {
+        if(nd.m_injected.load(std::memory_order_relaxed) == 0)
+            return nullptr;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        operation_base* op = nd.m_head;
+        if(!op)
+            return nullptr;
+        nd.m_head = op->m_next;
+        std::size_t taken = 1;
+        while(nd.m_head && taken < injection_batch) {
+            // once pushed, the operation can be stolen and completed, read its successor first
+            auto next = nd.m_head->m_next;
+            if(!w.m_deque.push(nd.m_head))
+                break;
+            nd.m_head = next;
+            taken++;
         }
+        if(!nd.m_head)
+            nd.m_tail = nullptr;
+        nd.m_injected.store(nd.m_injected.load(std::memory_order_relaxed) - taken,
+                            std::memory_order_relaxed);
+        lock.unlock();
+        if(taken > 1)
+            wake_one(w.m_node);
+        return op;
+    }
 
-        for(operation_base* op = m_depleted_head; op != nullptr; op = op->m_next) {
-            lock.unlock();
-            op->set_done();
-            lock.lock();
-            m_condition.notify_all();
+    // Whether there is work w can take, or any worker if w is null
+    bool has_work(const worker* w = nullptr) const noexcept {
+        if(m_shared.m_injected.load(std::memory_order_relaxed) != 0)
+            return true;
+        for(std::size_t i = 0; i < m_nodes.size(); ++i) {
+            if((!w || w->m_node == i) && m_nodes[i]->m_injected.load(std::memory_order_relaxed))
+                return true;
         }
+        for(auto& w : m_workers) {
+            if(!w->m_deque.empty())
+                return true;
+        }
+        return false;
+    }
 
-        m_head = m_tail = nullptr;
-        m_condition.notify_all();
+    // Spins for a while looking for work, then parks until woken up.
+    // Returns false when the pool is stopped
+    bool wait_for_work(worker& w) {
+        // while a worker spins, submissions it can take do not wake anyone, it will find them
+        auto& home = *m_nodes[w.m_node];
+        m_shared.m_spinning.fetch_add(1, std::memory_order_relaxed);
+        home.m_spinning.fetch_add(1, std::memory_order_relaxed);
+        bool found = false;
+        for(std::size_t i = 0; i < spin_rounds && !found; ++i) {
+            found = has_work(&w);
+            if(!found)
+                __spin_yield();
+        }
+        home.m_spinning.fetch_sub(1, std::memory_order_relaxed);
+        m_shared.m_spinning.fetch_sub(1, std::memory_order_relaxed);
+        return found || park(w);
+    }
 
+    bool park(worker& w) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        w.m_wake.store(0, std::memory_order_relaxed);
+        m_parked.push_back(&w);
+        m_sleeping.store(m_parked.size(), std::memory_order_relaxed);
+        // pairs with the fence in wake_one, either the submitter sees us parked,
+        // or we see its work
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(m_stopped || has_work(&w)) {
+            m_parked.pop_back();
+            m_sleeping.store(m_parked.size(), std::memory_order_relaxed);
+            return !m_stopped;
+        }
+        if(m_parked.size() == m_workers.size() && m_depleted_head) {
+            // the last worker to park completes the depleted senders
+            on_depleted(lock);
+            // the receivers may have scheduled work, look again
+            if(w.m_wake.load(std::memory_order_relaxed) == 0) {
+                std::erase(m_parked, &w);
+                m_sleeping.store(m_parked.size(), std::memory_order_relaxed);
+            }
+            return !m_stopped;
+        }
         lock.unlock();
+        w.m_wake.wait(0, std::memory_order_acquire);
+        return true;
+    }
 
-        for(auto&& t : m_threads) {
-            t.join();
-            m_condition.notify_all();
-        }
+    // Wakes up one parked worker for work pushed to a deque of nd, if no worker is already
+    // looking for work. Any worker can steal it, those of nd are preferred
+    void wake_one(std::size_t nd) noexcept {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(m_sleeping.load(std::memory_order_relaxed) == 0 ||
+           m_shared.m_spinning.load(std::memory_order_relaxed) != 0)
+            return;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        unpark_locked(nd) || unpark_locked(any_node);
     }
 
-    auto scheduler() noexcept {
-        return stp_scheduler(*this);
+    // Wakes up the last parked worker of node nd, or of any node for any_node.
+    // Returns false if there is none
+    bool unpark_locked(std::size_t nd) noexcept {
+        auto it = std::find_if(m_parked.rbegin(), m_parked.rend(), [nd](worker* w) {
+            return nd == any_node || w->m_node == nd;
+        });
+        if(it == m_parked.rend())
+            return false;
+        worker* w = *it;
+        m_parked.erase(std::next(it).base());
+        m_sleeping.store(m_parked.size(), std::memory_order_relaxed);
+        w->m_wake.store(1, std::memory_order_release);
+        w->m_wake.notify_one();
+        return true;
     }
 
-    depleted_sender depleted() noexcept {
-        return depleted_sender(*this);
+    // Number of workers operations scheduled on target may run on
+    std::size_t workers_of(std::size_t target) const noexcept {
+        return target == any_node ? m_workers.size() : m_nodes[target]->m_workers.size();
     }
 
+    // The worker operations scheduled on target are pushed to, if called from one
+    worker* local_worker(std::size_t target) noexcept {
+        auto& c = current();
+        if(c.pool != this || (target != any_node && target != c.w->m_node))
+            return nullptr;
+        return c.w;
+    }
 
-    ~static_thread_pool() {
-        stop();
+    // The injection queue of target
+    node& queue_of(std::size_t target) noexcept {
+        return target == any_node ? m_shared : *m_nodes[target];
     }
 
-private:
-    void execute(static_thread_pool::operation_base& op) {
+    void execute(static_thread_pool::operation_base& op, std::size_t target) {
+        if(auto w = local_worker(target); w && w->m_deque.push(&op)) {
+            wake_one(w->m_node);
+            return;
+        }
+        auto& q = queue_of(target);
         std::unique_lock<std::mutex> lock(m_mutex);
-        if(m_head == nullptr) {
-            m_head = m_tail = &op;
+        op.m_next = nullptr;
+        if(q.m_head == nullptr) {
+            q.m_head = q.m_tail = &op;
         } else {
-            m_tail->m_next = &op;
-            m_tail = &op;
+            q.m_tail->m_next = &op;
+            q.m_tail = &op;
         }
-        m_condition.notify_all();
+        q.m_injected.store(q.m_injected.load(std::memory_order_relaxed) + 1,
+                           std::memory_order_relaxed);
+        if(q.m_spinning.load(std::memory_order_relaxed) == 0)
+            unpark_locked(target);
     }
 
+    // Schedules the operations linked through m_next, and wakes up as many parked workers.
+    // Unlike execute, spinning workers do not prevent that, they would only take one each
+    void execute_all(operation_base* op, std::size_t target) {
+        std::size_t n = 0;
+        auto local = any_node;
+        if(auto w = local_worker(target)) {
+            local = w->m_node;
+            while(op) {
+                // op may run, and complete the whole list, as soon as it is pushed
+                auto next = op->m_next;
+                if(!w->m_deque.push(op))
+                    break;
+                op = next;
+                n++;
+            }
+            if(!op) {
+                wake(n, local);
+                return;
+            }
+        }
+        auto& q = queue_of(target);
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if(q.m_head == nullptr)
+            q.m_head = op;
+        else
+            q.m_tail->m_next = op;
+        std::size_t injected = 0;
+        for(; op; op = op->m_next) {
+            q.m_tail = op;
+            injected++;
+        }
+        q.m_injected.store(q.m_injected.load(std::memory_order_relaxed) + injected,
+                           std::memory_order_relaxed);
+        for(; injected > 0 && unpark_locked(target); injected--)
+            ;
+        for(; n > 0 && (unpark_locked(local) || unpark_locked(any_node)); n--)
+            ;
+    }
+
+    // Wakes up to n parked workers for work pushed to a deque of nd, preferably of nd
+    void wake(std::size_t n, std::size_t nd) noexcept {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(m_sleeping.load(std::memory_order_relaxed) == 0)
+            return;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for(; n > 0 && (unpark_locked(nd) || unpark_locked(any_node)); n--)
+            ;
+    }
+
+    // Depleted operations complete when all workers are idle and there is no work left
     void register_depleted_sender(static_thread_pool::operation_base& op) {
         std::unique_lock<std::mutex> lock(m_mutex);
+        if(m_stopped) {
+            lock.unlock();
+            op.set_done();
+            return;
+        }
+        if(m_parked.size() == m_workers.size() && !has_work()) {
+            lock.unlock();
+            op.set_value();
+            return;
+        }
+        op.m_next = nullptr;
         if(m_depleted_head == nullptr) {
             m_depleted_head = m_depleted_tail = &op;
         } else {
             m_depleted_tail->m_next = &op;
-            m_depleted_head = &op;
+            m_depleted_tail = &op;
         }
-        m_condition.notify_all();
     }
 
-    void on_depleted() {
-        m_tail = nullptr;
-        for(operation_base* op = m_depleted_head; op != nullptr; op = op->m_next) {
+    void on_depleted(std::unique_lock<std::mutex>& lock) {
+        auto op = std::exchange(m_depleted_head, nullptr);
+        m_depleted_tail = nullptr;
+        // the receivers may schedule more work, which needs the lock
+        lock.unlock();
+        while(op) {
+            auto next = op->m_next;
             op->set_value();
+            op = next;
+        }
+        lock.lock();
+    }
+
+    static void done_all(operation_base* op) noexcept {
+        while(op) {
+            auto next = op->m_next;
+            op->set_done();
+            op = next;
         }
-        m_depleted_head = nullptr;
-        m_condition.notify_all();
     }
 
 
     std::mutex m_mutex;
-    std::condition_variable m_condition;
+    std::vector<std::unique_ptr<worker>> m_workers;
     std::vector<std::thread> m_threads;
-    operation_base* m_head = nullptr;
-    operation_base* m_tail = nullptr;
+    std::vector<std::unique_ptr<node>> m_nodes;
+    // queue of operations scheduled on any node from outside of the pool,
+    // its m_spinning counts all the workers looking for work
+    node m_shared;
+    // workers waiting to be woken up, and their number, which is checked without the lock
+    std::vector<worker*> m_parked;
+    std::atomic_size_t m_sleeping = 0;
 
     operation_base* m_depleted_head = nullptr;
     operation_base* m_depleted_tail = nullptr;
@@ -275,4 +838,4 @@ private:
 };
 
 
-}  // namespace cor3ntin::corio
+}  // namespace cor3ntin::corio
\ No newline at end of file
@@ -0,0 +1,20 @@
+#pragma once
+#include <corio/tag_invoke.hpp>
+#include <corio/deadline.hpp>
+
+namespace cor3ntin::corio {
+
+// timeout(sender, deadline) bounds the operation of sender by the deadline.
+// Senders opt in by customizing timeout through tag_invoke
+namespace __timeout_ns {
+    struct __timeout_base {};
+}  // namespace __timeout_ns
+inline constexpr struct __timeout_fn : __timeout_ns::__timeout_base {
+    template <typename Sender>
+    requires cor3ntin::corio::tag_invocable<__timeout_fn, Sender, deadline> auto
+    operator()(Sender&& s, deadline d) const {
+        return cor3ntin::corio::tag_invoke(*this, (Sender &&) s, d);
+    }
+} timeout;
+
+}  // namespace cor3ntin::corio
@@ -0,0 +1,155 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <limits>
+
+namespace cor3ntin::corio {
+
+// Hierarchical timer wheel.
+// Time is counted in ticks. Each level has 64 slots, level n slots span 64^n ticks.
+// A timer is stored at the level of the most significant 6 bits group in which its expiry
+// differs from the current tick, and moves down the levels as time advances.
+// Insertion and removal are O(1), finding the next event is O(levels).
+class timer_wheel {
+public:
+    using tick = std::uint64_t;
+    static constexpr tick never = std::numeric_limits<tick>::max();
+
+    class node {
+        friend timer_wheel;
+
+    public:
+        bool linked() const noexcept {
+            return m_prev != nullptr;
+        }
+        tick expiry() const noexcept {
+            return m_expiry;
+        }
+
+    private:
+        node* m_next = nullptr;
+        node** m_prev = nullptr;
+        tick m_expiry = 0;
+        std::uint8_t m_level = 0;
+        std::uint8_t m_slot = 0;
+    };
+
+    tick now() const noexcept {
+        return m_now;
+    }
+
+    bool empty() const noexcept {
+        return m_size == 0;
+    }
+
+    std::size_t size() const noexcept {
+        return m_size;
+    }
+
+    // expiry must be after now()
+    void insert(node* n, tick expiry) noexcept {
+        n->m_expiry = expiry;
+        link(n);
+        m_size++;
+    }
+
+    void remove(node* n) noexcept {
+        unlink(n);
+        m_size--;
+    }
+
+    // The tick at which advance() will next have work to do: either a timer expires or timers
+    // need to move to a lower level. never if the wheel is empty
+    tick next_event() const noexcept {
+        unsigned level;
+        return next_event(level);
+    }
+
+    // Moves the current tick to to, calling expired(node*) for each timer whose expiry is
+    // reached. Expired timers are removed before the callback is called.
+    template <typename F>
+    void advance(tick to, F&& expired) {
+        while(true) {
+            unsigned level;
+            const tick next = next_event(level);
+            if(next == never || next > to) {
+                if(to > m_now) {
+                    m_now = to;
+                }
+                return;
+            }
+            m_now = next;
+            const unsigned slot = slot_of(m_now, level);
+            while(node* n = m_slots[level][slot]) {
+                unlink(n);
+                if(n->m_expiry <= m_now) {
+                    m_size--;
+                    expired(n);
+                } else {
+                    link(n);
+                }
+            }
+        }
+    }
+
+private:
+    static constexpr unsigned slot_bits = 6;
+    static constexpr unsigned slots = 1 << slot_bits;
+    static constexpr unsigned slot_mask = slots - 1;
+    static constexpr unsigned levels = (64 + slot_bits - 1) / slot_bits;
+
+    tick next_event(unsigned& level) const noexcept {
+        for(level = 0; level < levels; level++) {
+            const unsigned shift = level * slot_bits;
+            const unsigned current = slot_of(m_now, level);
+            // slots up to the current one are empty
+            const std::uint64_t pending =
+                current == slot_mask ? 0 : m_occupied[level] & (~std::uint64_t(0) << (current + 1));
+            if(pending) {
+                const unsigned slot = __builtin_ctzll(pending);
+                const unsigned block_shift = shift + slot_bits;
+                const tick block = block_shift >= 64 ? 0 : (m_now >> block_shift) << block_shift;
+                return block | (tick(slot) << shift);
+            }
+        }
+        return never;
+    }
+
+    static unsigned slot_of(tick t, unsigned level) noexcept {
+        return (t >> (level * slot_bits)) & slot_mask;
+    }
+
+    void link(node* n) noexcept {
+        const unsigned level = (63 - __builtin_clzll(n->m_expiry ^ m_now)) / slot_bits;
+        const unsigned slot = slot_of(n->m_expiry, level);
+        node*& head = m_slots[level][slot];
+        n->m_level = level;
+        n->m_slot = slot;
+        n->m_next = head;
+        n->m_prev = &head;
+        if(head) {
+            head->m_prev = &n->m_next;
+        }
+        head = n;
+        m_occupied[level] |= std::uint64_t(1) << slot;
+    }
+
+    void unlink(node* n) noexcept {
+        *n->m_prev = n->m_next;
+        if(n->m_next) {
+            n->m_next->m_prev = n->m_prev;
+        }
+        if(!m_slots[n->m_level][n->m_slot]) {
+            m_occupied[n->m_level] &= ~(std::uint64_t(1) << n->m_slot);
+        }
+        n->m_next = nullptr;
+        n->m_prev = nullptr;
+    }
+
+    tick m_now = 0;
+    std::size_t m_size = 0;
+    std::array<std::uint64_t, levels> m_occupied{};
+    std::array<std::array<node*, slots>, levels> m_slots{};
+};
+
+}  // namespace cor3ntin::corio
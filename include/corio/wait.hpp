@@ -5,6 +5,8 @@
 #include <thread>
 #include <queue>
 #include <exception>
+#include <condition_variable>
+#include <mutex>
 
 namespace cor3ntin::corio {
 
@@ -13,22 +15,31 @@ bool wait(execution::sender auto&& send) {
     struct state {
         std::mutex m;
         std::condition_variable c;
+        bool completed = false;
         bool cancelled = false;
         std::exception_ptr err;
+
+        // the sender may complete before wait blocks, or from start() itself
+        void complete() {
+            std::unique_lock<std::mutex> lock(m);
+            completed = true;
+            c.notify_one();
+        }
     } s;
 
     struct r {
         void set_value() {
-            s.c.notify_one();
+            s.complete();
         }
 
         void set_done() {
             s.cancelled = true;
-            s.c.notify_one();
+            s.complete();
         }
 
         void set_error(std::exception_ptr ptr) {
             s.err = ptr;
+            s.complete();
         }
         state& s;
     };
@@ -40,7 +51,7 @@ bool wait(execution::sender auto&& send) {
     op.start();
 
     std::unique_lock<std::mutex> lock(s.m);
-    s.c.wait(lock);
+    s.c.wait(lock, [&s] { return s.completed; });
 
     if(s.err) {
         std::rethrow_exception(s.err);
@@ -0,0 +1,86 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace cor3ntin::corio {
+
+// Chase-Lev deque of T*, with the memory orderings of
+// "Correct and Efficient Work-Stealing for Weak Memory Models" (Lê et al, 2013).
+// The owning thread pushes and pops at the bottom, other threads steal from the top.
+// The capacity is fixed, push fails when the deque is full.
+template <typename T>
+class work_stealing_deque {
+public:
+    // capacity must be a power of 2
+    explicit work_stealing_deque(std::size_t capacity)
+        : m_mask(std::int64_t(capacity) - 1), m_buffer(new std::atomic<T*>[capacity]) {}
+
+    work_stealing_deque(const work_stealing_deque&) = delete;
+    work_stealing_deque& operator=(const work_stealing_deque&) = delete;
+
+    // Owner only
+    bool push(T* const item) noexcept {
+        const auto b = m_bottom.load(std::memory_order_relaxed);
+        const auto t = m_top.load(std::memory_order_acquire);
+        if(b - t > m_mask) {
+            return false;
+        }
+        m_buffer[b & m_mask].store(item, std::memory_order_relaxed);
+        m_bottom.store(b + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Owner only, returns the most recently pushed item
+    T* pop() noexcept {
+        const auto b = m_bottom.load(std::memory_order_relaxed) - 1;
+        m_bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto t = m_top.load(std::memory_order_relaxed);
+        if(t > b) {
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        T* item = m_buffer[b & m_mask].load(std::memory_order_relaxed);
+        if(t == b) {
+            // last item, race against thieves for it
+            if(!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                              std::memory_order_relaxed)) {
+                item = nullptr;
+            }
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    // Any thread, returns the oldest item.
+    // Returns nullptr when empty or when another thread took the item first
+    T* steal() noexcept {
+        auto t = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const auto b = m_bottom.load(std::memory_order_acquire);
+        if(t >= b) {
+            return nullptr;
+        }
+        T* item = m_buffer[t & m_mask].load(std::memory_order_relaxed);
+        if(!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                          std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return item;
+    }
+
+    // Any thread, only a hint unless called by the owner
+    bool empty() const noexcept {
+        return m_bottom.load(std::memory_order_relaxed) <= m_top.load(std::memory_order_relaxed);
+    }
+
+private:
+    // top and bottom are written by different threads
+    alignas(64) std::atomic<std::int64_t> m_top = 0;
+    alignas(64) std::atomic<std::int64_t> m_bottom = 0;
+    const std::int64_t m_mask;
+    const std::unique_ptr<std::atomic<T*>[]> m_buffer;
+};
+
+}  // namespace cor3ntin::corio
@@ -1,40 +1,68 @@
 #include <corio/corio.hpp>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
 #include <iostream>
+#include <numeric>
 #include <random>
+#include <ranges>
+#include <string_view>
 
 
-template <typename scheduler>
-cor3ntin::corio::oneway_task compute_pi(scheduler my_scheduler, std::vector<int>& v, int n,
-                                        int slot) {
-
-    co_await my_scheduler.schedule();
+// Estimates pi from jobs * iters random points, each job counting the points in the circle.
+// The counts are combined by transform_reduce rather than written to a shared vector
+double compute_pi(static_thread_pool& p) {
+    static constexpr auto jobs = 100'000;
+    static constexpr auto iters = 10'000;
 
-    static thread_local auto gen = [] {
-        std::mt19937 e;
-        std::random_device rdev;
-        e.seed(rdev());
-        return e;
-    }();
-    auto dist = std::uniform_real_distribution<>{0, 1};
-    for(auto i = 0; i < n; i++) {
-        if(std::sqrt(std::pow(dist(gen), 2) + std::pow(dist(gen), 2)) < 1)
-            v[slot]++;
-    }
+    const auto range = std::views::iota(0, jobs);
+    long hits = 0;
+    wait(cor3ntin::corio::then(
+        cor3ntin::corio::transform_reduce(p.scheduler(), range.begin(), range.end(), 0l,
+                                          std::plus<>{},
+                                          [](int) {
+                                              static thread_local auto gen = [] {
+                                                  std::mt19937 e;
+                                                  std::random_device rdev;
+                                                  e.seed(rdev());
+                                                  return e;
+                                              }();
+                                              auto dist = std::uniform_real_distribution<>{0, 1};
+                                              long n = 0;
+                                              for(auto i = 0; i < iters; i++) {
+                                                  if(std::sqrt(std::pow(dist(gen), 2) +
+                                                               std::pow(dist(gen), 2)) < 1)
+                                                      n++;
+                                              }
+                                              return n;
+                                          },
+                                          1),
+        [&hits](long h) { hits = h; }));
+    return 4.0 * static_cast<double>(hits) / static_cast<double>(long(jobs) * iters);
 }
 
-double compute_pi() {
-    static constexpr auto jobs = 100'000;
-    static constexpr auto iters = 10'000;
-    std::vector<int> v(jobs);
+// Sums floats on a thread pool, returns the number of them summed per second
+double float_sum() {
+    static constexpr std::size_t n = 1 << 26;
+    std::vector<float> v(n, 0.5f);
     static_thread_pool p(std::thread::hardware_concurrency());
 
-    for(int i = 0; i < jobs; i++) {
-        compute_pi(p.scheduler(), v, iters, i);
+    float sum = 0;
+    const auto start = std::chrono::steady_clock::now();
+    wait(cor3ntin::corio::then(cor3ntin::corio::reduce(p.scheduler(), v.begin(), v.end(), 0.0f),
+                               [&sum](float s) { sum = s; }));
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    if(sum != 0.5f * n) {
+        std::cerr << "float_sum: " << sum << "\n";
     }
-
-    wait(p.depleted());
-    return 4.0 * static_cast<double>(std::accumulate(v.begin(), v.end(), 0)) /
-        static_cast<double>(jobs * iters);
+    return double(n) / elapsed.count();
 }
 
 using namespace cor3ntin::corio;
@@ -70,7 +98,416 @@ oneway_task pong(scheduler sch, auto r, auto w, stop_source& stop, int n) {
     }
 }
 
-int main() {
+template <execution::scheduler scheduler>
+oneway_task schedule_loop(scheduler sch, int n, std::atomic_int& remaining, stop_source& stop) {
+    for(int i = 0; i < n; i++) {
+        co_await sch.schedule();
+    }
+    if(remaining.fetch_sub(1) == 1) {
+        stop.request_stop();
+    }
+}
+
+// schedule() without a deadline is a NOP submission,
+// returns the number of them completed per second
+double nop_throughput() {
+    static constexpr auto tasks = 256;
+    static constexpr auto iters = 10'000;
+    stop_source stop;
+    io_uring_context ctx;
+    std::atomic_int remaining = tasks;
+
+    const auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < tasks; i++) {
+        schedule_loop(ctx.scheduler(), iters, remaining, stop);
+    }
+    ctx.run(stop.get_token());
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return double(tasks) * iters / elapsed.count();
+}
+
+template <execution::scheduler scheduler>
+oneway_task timer_loop(scheduler sch, int n, std::atomic_int& remaining, stop_source& stop) {
+    for(int i = 0; i < n; i++) {
+        co_await sch.schedule(std::chrono::milliseconds(1));
+    }
+    if(remaining.fetch_sub(1) == 1) {
+        stop.request_stop();
+    }
+}
+
+// Keeps tasks 1ms timers pending at once, returns the number of them completed per second.
+// A resolution of 0 submits a kernel timeout for each timer rather than using the timer wheel
+double timer_throughput(std::chrono::nanoseconds resolution) {
+    static constexpr auto tasks = 10'000;
+    static constexpr auto iters = 100;
+    stop_source stop;
+    io_uring_options options;
+    options.timer_resolution = resolution;
+    io_uring_context ctx(options);
+    std::atomic_int remaining = tasks;
+
+    const auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < tasks; i++) {
+        timer_loop(ctx.scheduler(), iters, remaining, stop);
+    }
+    ctx.run(stop.get_token());
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return double(tasks) * iters / elapsed.count();
+}
+
+// Loopback TCP echo: each client sends a message, waits for its echo, and does it again
+static constexpr int echo_clients = 32;
+static constexpr int echo_round_trips = 10'000;
+static constexpr std::size_t echo_message_size = 64;
+
+int tcp_socket() {
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+    return fd;
+}
+
+// Listens on an ephemeral port of the loopback interface, whose address is stored in addr
+int listen_loopback(sockaddr_in& addr) {
+    int fd = tcp_socket();
+    addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof addr;
+    if(::bind(fd, (sockaddr*)&addr, len) < 0 || ::listen(fd, echo_clients) < 0 ||
+       ::getsockname(fd, (sockaddr*)&addr, &len) < 0) {
+        std::cerr << "echo: cannot listen on the loopback interface\n";
+        std::exit(1);
+    }
+    return fd;
+}
+
+template <execution::scheduler scheduler>
+oneway_task echo_session(scheduler sch, int fd) {
+    char buffer[echo_message_size];
+    try {
+        while(std::size_t n = co_await async_recv(sch, fd, buffer, sizeof buffer)) {
+            co_await async_send(sch, fd, buffer, n, MSG_NOSIGNAL);
+        }
+    } catch(...) {
+    }
+    ::close(fd);
+}
+
+template <execution::scheduler scheduler>
+oneway_task echo_server(scheduler sch, int listener) {
+    for(int i = 0; i < echo_clients; i++) {
+        int fd = co_await async_accept(sch, listener);
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+        echo_session(sch, fd);
+    }
+}
+
+struct echo_result {
+    double round_trips_per_second;
+    std::chrono::nanoseconds mean;
+    std::chrono::nanoseconds p99;
+};
+
+echo_result echo_summary(std::vector<std::chrono::nanoseconds>& latencies, double seconds) {
+    std::sort(latencies.begin(), latencies.end());
+    const auto total = std::accumulate(latencies.begin(), latencies.end(),
+                                       std::chrono::nanoseconds(0));
+    return {double(latencies.size()) / seconds, total / latencies.size(),
+            latencies[latencies.size() * 99 / 100]};
+}
+
+std::ostream& operator<<(std::ostream& os, const echo_result& r) {
+    return os << r.round_trips_per_second << " round trips/s, mean " << r.mean.count()
+              << "ns, p99 " << r.p99.count() << "ns";
+}
+
+// latencies are shared by the clients, which all run on the thread running the context
+template <execution::scheduler scheduler>
+oneway_task echo_client(scheduler sch, sockaddr_in addr, std::atomic_int& remaining,
+                        stop_source& stop, std::vector<std::chrono::nanoseconds>& latencies) {
+    int fd = tcp_socket();
+    char buffer[echo_message_size] = {};
+    co_await async_connect(sch, fd, (sockaddr*)&addr, sizeof addr);
+    for(int i = 0; i < echo_round_trips; i++) {
+        const auto sent = std::chrono::steady_clock::now();
+        co_await async_send(sch, fd, buffer, sizeof buffer, MSG_NOSIGNAL);
+        for(std::size_t received = 0; received < sizeof buffer;) {
+            received += co_await async_recv(sch, fd, buffer + received, sizeof buffer - received);
+        }
+        latencies.push_back(std::chrono::steady_clock::now() - sent);
+    }
+    ::close(fd);
+    if(remaining.fetch_sub(1) == 1) {
+        stop.request_stop();
+    }
+}
+
+// Clients and server on one io_uring_context
+echo_result echo_throughput() {
+    sockaddr_in addr;
+    const int listener = listen_loopback(addr);
+    stop_source stop;
+    io_uring_context ctx;
+    std::atomic_int remaining = echo_clients;
+    std::vector<std::chrono::nanoseconds> latencies;
+    latencies.reserve(echo_clients * echo_round_trips);
+
+    const auto start = std::chrono::steady_clock::now();
+    echo_server(ctx.scheduler(), listener);
+    for(int i = 0; i < echo_clients; i++) {
+        echo_client(ctx.scheduler(), addr, remaining, stop, latencies);
+    }
+    ctx.run(stop.get_token());
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    ::close(listener);
+    return echo_summary(latencies, elapsed.count());
+}
+
+// The same exchange with non blocking sockets and a level-triggered epoll loop
+echo_result epoll_echo_throughput() {
+    struct connection {
+        int fd;
+        bool client;
+        int round_trips = 0;
+        std::size_t received = 0;
+        std::chrono::steady_clock::time_point sent;
+        char buffer[echo_message_size] = {};
+    };
+    sockaddr_in addr;
+    const int listener = listen_loopback(addr);
+    const int epoll = ::epoll_create1(EPOLL_CLOEXEC);
+    std::vector<std::unique_ptr<connection>> connections;
+    std::vector<std::chrono::nanoseconds> latencies;
+    latencies.reserve(echo_clients * echo_round_trips);
+
+    const auto start = std::chrono::steady_clock::now();
+    // the listen backlog holds every client, connect does not wait for accept
+    for(int i = 0; i < echo_clients; i++) {
+        int fd = tcp_socket();
+        ::connect(fd, (sockaddr*)&addr, sizeof addr);
+        connections.emplace_back(new connection{fd, true});
+    }
+    for(int i = 0; i < echo_clients; i++) {
+        int fd = ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+        connections.emplace_back(new connection{fd, false});
+    }
+    for(auto& c : connections) {
+        ::fcntl(c->fd, F_SETFL, O_NONBLOCK);
+        epoll_event ev{EPOLLIN, {.ptr = c.get()}};
+        ::epoll_ctl(epoll, EPOLL_CTL_ADD, c->fd, &ev);
+        if(c->client) {
+            c->sent = std::chrono::steady_clock::now();
+            ::send(c->fd, c->buffer, sizeof c->buffer, MSG_NOSIGNAL);
+        }
+    }
+
+    int remaining = echo_clients;
+    epoll_event events[64];
+    while(remaining > 0) {
+        const int n = ::epoll_wait(epoll, events, 64, -1);
+        for(int i = 0; i < n; i++) {
+            auto& c = *static_cast<connection*>(events[i].data.ptr);
+            if(!c.client) {
+                const auto size = ::recv(c.fd, c.buffer, sizeof c.buffer, 0);
+                if(size > 0) {
+                    ::send(c.fd, c.buffer, std::size_t(size), MSG_NOSIGNAL);
+                } else if(size == 0) {
+                    ::epoll_ctl(epoll, EPOLL_CTL_DEL, c.fd, nullptr);
+                }
+                continue;
+            }
+            const auto size = ::recv(c.fd, c.buffer + c.received,
+                                     sizeof c.buffer - c.received, 0);
+            if(size <= 0) {
+                continue;
+            }
+            c.received += std::size_t(size);
+            if(c.received < sizeof c.buffer) {
+                continue;
+            }
+            c.received = 0;
+            latencies.push_back(std::chrono::steady_clock::now() - c.sent);
+            if(++c.round_trips == echo_round_trips) {
+                ::epoll_ctl(epoll, EPOLL_CTL_DEL, c.fd, nullptr);
+                ::shutdown(c.fd, SHUT_WR);
+                remaining--;
+            } else {
+                c.sent = std::chrono::steady_clock::now();
+                ::send(c.fd, c.buffer, sizeof c.buffer, MSG_NOSIGNAL);
+            }
+        }
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    for(auto& c : connections) {
+        ::close(c->fd);
+    }
+    ::close(epoll);
+    ::close(listener);
+    return echo_summary(latencies, elapsed.count());
+}
+
+// Streams stream_bytes over a loopback TCP connection in messages of a given size
+static constexpr std::size_t stream_bytes = std::size_t(1) << 30;
+
+template <bool ZeroCopy, execution::scheduler scheduler>
+oneway_task stream_sender(scheduler sch, int fd, const char* buffer, std::size_t size) {
+    try {
+        for(std::size_t sent = 0; sent < stream_bytes;) {
+            if constexpr(ZeroCopy) {
+                sent += co_await async_send_zc(sch, fd, buffer, size, MSG_NOSIGNAL);
+            } else {
+                sent += co_await async_send(sch, fd, buffer, size, MSG_NOSIGNAL);
+            }
+        }
+    } catch(...) {
+    }
+    ::shutdown(fd, SHUT_WR);
+}
+
+template <execution::scheduler scheduler>
+oneway_task stream_receiver(scheduler sch, int fd, char* buffer, std::size_t size,
+                            stop_source& stop) {
+    try {
+        while(co_await async_recv(sch, fd, buffer, size)) {
+        }
+    } catch(...) {
+    }
+    stop.request_stop();
+}
+
+struct stream_result {
+    double bytes_per_second;
+    // user and system time of the process, both ends included, per GB streamed
+    double cpu_seconds_per_gb;
+};
+
+double cpu_seconds() {
+    rusage usage;
+    ::getrusage(RUSAGE_SELF, &usage);
+    auto seconds = [](timeval t) { return double(t.tv_sec) + double(t.tv_usec) / 1e6; };
+    return seconds(usage.ru_utime) + seconds(usage.ru_stime);
+}
+
+// Sends with async_send_zc, or async_send, messages of size bytes to a receiver on the same
+// io_uring_context
+template <bool ZeroCopy>
+stream_result stream_throughput(std::size_t size) {
+    sockaddr_in addr;
+    const int listener = listen_loopback(addr);
+    // the listen backlog holds the client, connect does not wait for accept
+    const int client = tcp_socket();
+    ::connect(client, (sockaddr*)&addr, sizeof addr);
+    const int server = ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+    std::vector<char> out(size, 'x');
+    std::vector<char> in(size);
+    stop_source stop;
+    io_uring_context ctx;
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto cpu_start = cpu_seconds();
+    stream_receiver(ctx.scheduler(), server, in.data(), in.size(), stop);
+    stream_sender<ZeroCopy>(ctx.scheduler(), client, out.data(), out.size());
+    ctx.run(stop.get_token());
+    const auto cpu = cpu_seconds() - cpu_start;
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    ::close(client);
+    ::close(server);
+    ::close(listener);
+    const double gb = double(stream_bytes) / 1e9;
+    return {double(stream_bytes) / elapsed.count(), cpu / gb};
+}
+
+stream_result send_throughput(std::size_t size) {
+    return stream_throughput<false>(size);
+}
+
+stream_result send_zc_throughput(std::size_t size) {
+    return stream_throughput<true>(size);
+}
+
+// corio bench runs the benchmarks instead of the ping pong example
+int benchmarks() {
+    std::cout << "nop: " << nop_throughput() << " ops/s\n";
+    std::cout << "timers, 1ms wheel: " << timer_throughput(std::chrono::milliseconds(1))
+              << " timers/s\n";
+    std::cout << "timers, one timeout each: " << timer_throughput(std::chrono::nanoseconds(0))
+              << " timers/s\n";
+    std::cout << "echo, io_uring: " << echo_throughput() << "\n";
+    std::cout << "echo, epoll: " << epoll_echo_throughput() << "\n";
+    // on loopback the receiving side copies the data anyway
+    std::cout << "send vs send_zc over loopback, which understates the zero copy gain\n";
+    for(std::size_t kb : {64, 256, 1024}) {
+        const auto copy = send_throughput(kb * 1024);
+        const auto zc = send_zc_throughput(kb * 1024);
+        std::cout << "  " << kb << "KB send: " << copy.bytes_per_second << " bytes/s, "
+                  << copy.cpu_seconds_per_gb << " cpu s/GB, send_zc: " << zc.bytes_per_second
+                  << " bytes/s, " << zc.cpu_seconds_per_gb << " cpu s/GB\n";
+    }
+    std::cout << "float sum: " << float_sum() << " floats/s\n";
+    // scaling of the work stealing pool, pools with more threads than cpus oversubscribe them
+    for(std::size_t threads = 1; threads <= 64; threads *= 2) {
+        static_thread_pool p(threads);
+        const auto start = std::chrono::steady_clock::now();
+        const double pi = compute_pi(p);
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << "pi, " << threads << " threads: " << pi << " in " << elapsed.count()
+                  << " s\n";
+    }
+    return 0;
+}
+
+template <execution::scheduler scheduler>
+oneway_task set_when_scheduled(scheduler sch, bool& done) {
+    co_await sch.schedule();
+    done = true;
+}
+
+// A loop waiting on a registered eventfd and calling poll() gets the completions
+// of a defer_taskrun context, which are only posted once the thread enters the kernel
+bool poll_defer_taskrun() {
+    io_uring_options options;
+    options.defer_taskrun = true;
+    io_uring_context ctx(options);
+    const int fd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    ctx.register_eventfd(fd);
+    bool done = false;
+    set_when_scheduled(ctx.scheduler(), done);
+    for(int i = 0; i < 100 && !done; i++) {
+        ctx.poll();
+        pollfd p{fd, POLLIN, 0};
+        if(::poll(&p, 1, 10) > 0) {
+            eventfd_t value;
+            eventfd_read(fd, &value);
+        }
+    }
+    ctx.unregister_eventfd();
+    ::close(fd);
+    return done;
+}
+
+// corio check runs the checks, and fails if one of them does
+int checks() {
+    int failed = 0;
+    auto check = [&failed](const char* name, bool ok) {
+        std::cout << name << ": " << (ok ? "ok" : "FAILED") << "\n";
+        failed += !ok;
+    };
+    check("poll on a defer_taskrun context", poll_defer_taskrun());
+    return failed ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    if(argc > 1 && std::string_view(argv[1]) == "bench") {
+        return benchmarks();
+    }
+    if(argc > 1 && std::string_view(argv[1]) == "check") {
+        return checks();
+    }
     stop_source stop;
     io_uring_context ctx;
     std::thread t([&ctx, &stop] { ctx.run(stop.get_token()); });